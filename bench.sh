@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Builds the headless attractor benchmark in each optimization configuration
+# and reports its speedup over a plain Release build.
+# Usage: ./bench.sh [frames]
+
+FRAMES=${1:-50}
+BENCH=Allolib-Kickstart-bench
+PGO_DIR=$(pwd)/build/bench-pgo/profiles
+
+# configures, builds and runs one configuration, printing its ms/frame
+run_config() {
+  local name=$1
+  shift
+  cmake -DCMAKE_BUILD_TYPE=Release -Wno-deprecated -DBUILD_EXAMPLES=0 "$@" -B build/bench-${name} -S . > /dev/null &&
+  cmake --build build/bench-${name} --config Release --target ${BENCH} -j 9 > /dev/null &&
+  ./bin/${BENCH} ${FRAMES} | awk '/^frame:/ { print $2 }'
+}
+
+report() {
+  awk -v name="$1" -v ms="$2" -v base="$3" \
+    'BEGIN { printf "%-10s %10.3f ms/frame %6.2fx\n", name, ms, base / ms }'
+}
+
+base=$(run_config release)
+[ -z "${base}" ] && { echo "release build failed"; exit 1; }
+report release ${base} ${base}
+
+ms=$(run_config lto -DALLOSKETCH_LTO=ON) && report lto ${ms} ${base}
+ms=$(run_config native -DALLOSKETCH_ARCH=native) && report native ${ms} ${base}
+
+# PGO: instrumented training run, then rebuild in the same directory
+rm -rf ${PGO_DIR}
+run_config pgo -DALLOSKETCH_PGO=GENERATE -DALLOSKETCH_PGO_DIR=${PGO_DIR} > /dev/null
+if ls ${PGO_DIR}/*.profraw > /dev/null 2>&1; then
+  llvm-profdata merge -output=${PGO_DIR}/default.profdata ${PGO_DIR}/*.profraw
+fi
+ms=$(run_config pgo -DALLOSKETCH_PGO=USE -DALLOSKETCH_PGO_DIR=${PGO_DIR}) && report pgo ${ms} ${base}
+
+ms=$(run_config all -DALLOSKETCH_LTO=ON -DALLOSKETCH_ARCH=native) && report lto+native ${ms} ${base}
@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# Simulates the sphere on localhost: one primary and N renderers of the app,
+# the primary playing a recorded show. Each node writes a report (frame rate,
+# sync latency, parameter-apply lag, I/O bytes) that is printed at the end
+# with its startup milestones and the loopback traffic of the whole run.
+# Without a display the nodes run under xvfb-run when it is installed.
+# Usage: ./cluster.sh [renderers] [show] [seconds]
+# Build first with ./run.sh or cmake; the first instance to start on a
+# machine becomes the primary.
+
+RENDERERS=${1:-3}
+SHOW=$(realpath ${2:-shows/demo.show})
+DURATION=${3:-60}
+REPORTS=$(pwd)/reports
+
+cd bin || exit 1
+RENDERER=./Allolib-Kickstart-renderer
+[ -x ${RENDERER} ] || RENDERER=./Allolib-Kickstart
+
+XVFB=""
+if [ -z "${DISPLAY}" ] && command -v xvfb-run > /dev/null; then
+  XVFB="xvfb-run -a"
+fi
+
+loopback_bytes() {
+  awk '$1 == "lo:" { print $2 + $10 }' /proc/net/dev
+}
+
+mkdir -p ${REPORTS}
+rm -f ${REPORTS}/node-*.txt
+before=$(loopback_bytes)
+
+${XVFB} ./Allolib-Kickstart --audio=null --show=${SHOW} --duration=${DURATION} \
+  --report=${REPORTS}/node-0.txt > ${REPORTS}/node-0.log 2>&1 &
+sleep 2  # let the primary claim its ports first
+
+for i in $(seq 1 ${RENDERERS}); do
+  ${XVFB} ${RENDERER} --audio=null --duration=${DURATION} --name=renderer-${i} \
+    --report=${REPORTS}/node-${i}.txt > ${REPORTS}/node-${i}.log 2>&1 &
+done
+
+wait
+after=$(loopback_bytes)
+
+for report in ${REPORTS}/node-*.txt; do
+  echo "== $(basename ${report} .txt)"
+  cat ${report}
+  grep -h '^\[startup\]' ${report%.txt}.log  # milestones, ms from process start
+done
+echo "== loopback bytes: $((after - before))"
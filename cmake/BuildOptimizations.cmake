@@ -0,0 +1,48 @@
+# Optional optimization configurations. They are applied globally, before
+# allolib is added, so the library code inlined into the hot loops (Mesh,
+# Vec) is built the same way as the app.
+#
+#   -DALLOSKETCH_LTO=ON            link-time optimization
+#   -DALLOSKETCH_ARCH=native       -march target (native, haswell, ...)
+#   -DALLOSKETCH_PGO=GENERATE|USE  profile-guided optimization, profiles in
+#                                  ALLOSKETCH_PGO_DIR (see bench.sh)
+
+option(ALLOSKETCH_LTO "Build with link-time optimization" OFF)
+set(ALLOSKETCH_ARCH "" CACHE STRING "Target ISA passed to -march, empty for the compiler default")
+set(ALLOSKETCH_PGO "OFF" CACHE STRING "Profile-guided optimization: OFF, GENERATE or USE")
+set_property(CACHE ALLOSKETCH_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(ALLOSKETCH_PGO_DIR ${CMAKE_BINARY_DIR}/pgo CACHE PATH "Directory PGO profiles are written to and read from")
+
+if(ALLOSKETCH_LTO)
+  include(CheckIPOSupported)
+  check_ipo_supported(RESULT LTO_SUPPORTED OUTPUT LTO_ERROR)
+  if(LTO_SUPPORTED)
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+  else()
+    message(WARNING "LTO not supported: ${LTO_ERROR}")
+  endif()
+endif()
+
+if(ALLOSKETCH_ARCH)
+  if(MSVC)
+    message(WARNING "ALLOSKETCH_ARCH is ignored with MSVC, use /arch via CMAKE_CXX_FLAGS")
+  else()
+    add_compile_options(-march=${ALLOSKETCH_ARCH})
+  endif()
+endif()
+
+if(ALLOSKETCH_PGO STREQUAL "GENERATE")
+  add_compile_options(-fprofile-generate=${ALLOSKETCH_PGO_DIR})
+  add_link_options(-fprofile-generate=${ALLOSKETCH_PGO_DIR})
+elseif(ALLOSKETCH_PGO STREQUAL "USE")
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    # clang reads the merged profile (llvm-profdata merge, done by bench.sh)
+    add_compile_options(-fprofile-use=${ALLOSKETCH_PGO_DIR}/default.profdata)
+    add_link_options(-fprofile-use=${ALLOSKETCH_PGO_DIR}/default.profdata)
+  else()
+    # gcc matches profiles by object path, so USE must be configured in the
+    # same build directory that ran GENERATE
+    add_compile_options(-fprofile-use=${ALLOSKETCH_PGO_DIR} -fprofile-correction)
+    add_link_options(-fprofile-use=${ALLOSKETCH_PGO_DIR})
+  endif()
+endif()
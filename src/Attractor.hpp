@@ -0,0 +1,497 @@
+// Attractor voice: integrates one of four strange attractors and draws the
+// trajectory as a ribbon or tube, or advects a cloud of particles through the same
+// vector field. A grid of streamlines can be overlaid to show the whole
+// flow, two captured trajectories can be morphed without integrating, and
+// several coupled copies can be integrated side by side. The ribbon's
+// width can trace the recent history of h, i.e. of the audio envelope.
+// snapshot() hands the geometry to the Exporter.
+// Shared by the app and the headless benchmark.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "al/graphics/al_Graphics.hpp"
+#include "al/graphics/al_VAOMesh.hpp"
+#include "al/scene/al_PolySynth.hpp"
+#include "al/ui/al_Parameter.hpp"
+#include "Exporter.hpp"
+#include "FrameArena.hpp"
+#include "Kernels.hpp"
+#include "Metrics.hpp"
+#include "Morph.hpp"
+#include "Particles.hpp"
+#include "Streamlines.hpp"
+using namespace al;
+
+class Attractor : public PositionedVoice {
+public:
+  // pipeline stages a parameter change invalidates; each stage also reruns
+  // the ones after it. width, tubeSides, morph and audioWidth only need
+  // RIBBON, light is draw state only and gain isn't visual at all.
+  enum Stage { INTEGRATE = 1, RIBBON = 2 };
+
+private:
+  static const int P = 15, D = 10;
+  static const int kParticles = 1 << 20, kParticleSteps = 4;
+  static constexpr float kEscape = 100 * D;  // particles past this reseed, streamlines stop
+  static constexpr float kCoupledOffset = 0.1f;  // x0 spacing of coupled copies
+  static const int kHistory = 512;  // h values audioWidth spreads along the curve
+  static constexpr float kQuietWidth = 0.2f;  // audioWidth's share at silence
+  Parameter p[P]{
+    {"N", "p", 10000, 0, 20000},    // p[0] = N     | (simulation steps)
+    {"h", "p", 0.01, 0, 0.018},     // p[1] = h     | (simulation time step)
+    {"x0", "p", 0, -D, D},          // p[2] = x0    | initial
+    {"y0", "p", 0.1, -D, D},        // p[3] = y0    | conditions
+    {"z0", "p", 0, -D, D},          // p[4] = z0    |
+    {"rho", "p", 28, 0, 56},        // p[5] = rho   | simulation
+    {"sigma", "p", 10, 0, 20},      // p[6] = sigma | parameters
+    {"beta", "p", 8.0f / 3, 0, 4},  // p[7] = beta  |
+    {"a", "p", 5, -D, 60},          // p[8] = a     |
+    {"b", "p", -10, -D, D},         // p[9] = b     |
+    {"c", "p", -10, -D, D},         // p[10] = c    |
+    {"d", "p", -10, -D, D},         // p[11] = d    |
+    {"e", "p", -10, -D, D},         // p[12] = e    |
+    {"o", "p", -10, -D, D},         // p[13] = o    |
+    {"g", "p", -10, -D, D},         // p[14] = g    |
+  };
+
+  Parameter width {"width", "", 0.07, 0, 0.2};  // ribbon width, tube radius
+  ParameterInt tubeSides {"tubeSides", "", 0, 0, kMaxTubeSides};  // 0: ribbon
+  Parameter gain {"gain", "", -90, -90, 0};
+  ParameterBool light {"light", "", false};  // switch light
+  ParameterInt mode {"mode", "", 0, 0, 3};
+  ParameterBool particles {"particles", "", false};  // cloud instead of orbit
+  ParameterBool streamlines {"streamlines", "", false};  // flow overlay
+  ParameterInt streamGrid {"streamGrid", "", 8, 2, 16};  // seeds per axis
+  ParameterInt streamSteps {"streamSteps", "", 500, 10, 1000};
+  Trigger captureA {"captureA", ""};  // current trajectory as morph end A
+  Trigger captureB {"captureB", ""};
+  Parameter morph {"morph", "", 0, 0, 1};  // 0 draws the live trajectory
+  ParameterInt coupled {"coupled", "", 1, 1, kMaxCoupled};  // copies integrated
+  Parameter coupling {"coupling", "", 0.5, 0, 10};  // pull towards their mean
+  ParameterBool audioWidth {"audioWidth", "", false};  // width follows h's history
+  // numbers the primary's commands; sent after the parameters a command
+  // changed, so the rebuild that sees it has seen them (see appliedSeq())
+  ParameterInt applySeq {"applySeq", "", 0, 0, INT32_MAX};
+  int consumedSeq = 0;
+  VAOMesh system;
+  Mesh point;
+  std::vector<float> points;  // integrated trajectories, xyz per step
+  int trajectories = 1;       // coupled systems in points, one after another
+  std::atomic<int> dirty{INTEGRATE};  // Stage bits, set from any thread
+  uint64_t rebuildCount = 0;
+  Particles cloud;  // allocated when particles is first switched on
+  Streamlines flow;  // traced with the INTEGRATE stage while streamlines is on
+  bool flowTraced = false;  // vertices changed since the last upload
+  int tubeCount = 0, tubeCountSides = 0, tubeCountSystems = 0;  // tube indices
+  Morph shapes;
+  std::atomic<int> captures{0};  // Morph::End bits, set from any thread
+  std::vector<float> blended;    // morphed trajectory
+  int deferred = 0;  // stages held back while morphing
+  std::atomic<float> hHistory[kHistory];  // ring of h changes, on every node
+  std::atomic<int> hHead{0};              // total h changes recorded
+
+  // drawing the blend of the captured ends instead of the live trajectory
+  bool morphing() { return morph > 0 && shapes.ready(); }
+
+  // Vec3f buffers as flat xyz arrays for the kernels
+  template <class Buffer>
+  static float* floats(Buffer& buffer) {
+    return &buffer[0][0];
+  }
+
+  void values(float* params) {
+    for (int i = 0; i < P; i++) {
+      params[i] = p[i];
+    }
+  }
+
+  // vertices the largest N needs with the current tubeSides and coupled:
+  // a ribbon doubles the N + 1 points of each system (plus the two that
+  // join it to the next), a tube multiplies them by its sides
+  int vertexCapacity() {
+    int points = (int)p[0].max() + 1;
+    return (sides() ? sides() * points : 2 * points + 2) * (int)coupled;
+  }
+
+  // two triangles per side between consecutive rings; ribbons need none
+  int indexCapacity() {
+    return 6 * sides() * (int)p[0].max() * (int)coupled;
+  }
+
+  // grows the CPU storage to what the enabled modes need at the largest N,
+  // so only switching a mode on (more sides or copies, particles) allocates
+  void reserve() {
+    int points = (int)p[0].max() + 1;
+    this->points.reserve(3 * points * (int)coupled);
+    system.vertices().reserve(vertexCapacity());
+    system.normals().reserve(vertexCapacity());
+    system.indices().reserve(indexCapacity());
+    if (particles && !cloud.count()) cloud.resize(kParticles, D);
+  }
+
+  // sides the tube is drawn with, 0 for the flat ribbon
+  int sides() { return tubeSides > 0 ? std::max(3, (int)tubeSides) : 0; }
+
+  // ring-to-ring triangles of `systems` count ring, `sides` sided tubes
+  // stored one after another; only rebuilt when the shape changed
+  void tubeIndices(int count, int sides, int systems) {
+    if (count == tubeCount && sides == tubeCountSides &&
+        systems == tubeCountSystems) return;
+    tubeCount = count;
+    tubeCountSides = sides;
+    tubeCountSystems = systems;
+    auto& indices = system.indices();
+    indices.resize(6 * sides * (count > 0 ? count - 1 : 0) * systems);
+    unsigned* index = indices.size() ? &indices[0] : nullptr;
+    for (int k = 0; k < systems; k++) {
+      unsigned first = k * count * sides;
+      for (int i = 0; i + 1 < count; i++) {
+        for (int j = 0; j < sides; j++) {
+          unsigned a = first + i * sides + j;
+          unsigned b = first + i * sides + (j + 1) % sides;
+          unsigned c = a + sides, d = b + sides;
+          *index++ = a, *index++ = b, *index++ = c;
+          *index++ = b, *index++ = d, *index++ = c;
+        }
+      }
+    }
+  }
+
+  // per-point widths from the h history, oldest at the start of the curve
+  // and newest at its head; relative to the loudest value so quiet input
+  // still shows. Valid until the end of the frame.
+  float* audioWidths(int count) {
+    float history[kHistory];
+    float loudest = 1e-9f;
+    int head = hHead.load(std::memory_order_acquire);
+    for (int j = 0; j < kHistory; j++) {
+      history[j] = hHistory[(head + j) % kHistory].load(std::memory_order_relaxed);
+      loudest = std::max(loudest, history[j]);
+    }
+
+    float* widths = FrameArena::local().allocate<float>(count);
+    for (int i = 0; i < count; i++) {
+      float t = count > 1 ? float(i) * (kHistory - 1) / (count - 1) : kHistory - 1;
+      int j = (int)t, next = std::min(j + 1, kHistory - 1);
+      float level = history[j] + (t - j) * (history[next] - history[j]);
+      widths[i] = width * (kQuietWidth + (1 - kQuietWidth) * level / loudest);
+    }
+    return widths;
+  }
+
+  // copies vertex (and normal) from into to
+  void copyVertex(int from, int to) {
+    system.vertices()[to] = system.vertices()[from];
+    system.normals()[to] = system.normals()[from];
+  }
+
+public:
+
+  void audioInput(float value) {
+    if (value != this->p[1].get()) {
+      this->p[1] = value;
+    }
+  }
+
+  void init() override {
+    for (int i = 0; i < P; i++) {
+      this->registerParameter(p[i]);
+    }
+    this->registerParameters(width, tubeSides, gain, light, mode, particles);
+    this->registerParameters(streamlines, streamGrid, streamSteps);
+    this->registerParameters(captureA, captureB, morph, coupled, coupling);
+    this->registerParameters(audioWidth, applySeq);
+
+    for (int i = 0; i < P; i++) {
+      p[i].registerChangeCallback([this](float) { invalidate(INTEGRATE); });
+    }
+    mode.registerChangeCallback([this](int32_t) { invalidate(INTEGRATE); });
+    coupled.registerChangeCallback([this](int32_t) { invalidate(INTEGRATE); });
+    coupling.registerChangeCallback([this](float) { invalidate(INTEGRATE); });
+    streamlines.registerChangeCallback([this](float) { invalidate(INTEGRATE); });
+    streamGrid.registerChangeCallback([this](int32_t) { invalidate(INTEGRATE); });
+    streamSteps.registerChangeCallback([this](int32_t) { invalidate(INTEGRATE); });
+    width.registerChangeCallback([this](float) { invalidate(RIBBON); });
+    tubeSides.registerChangeCallback([this](int32_t) { invalidate(RIBBON); });
+    morph.registerChangeCallback([this](float) { invalidate(RIBBON); });
+    audioWidth.registerChangeCallback([this](float) { invalidate(RIBBON); });
+    // a command that changed nothing visual still gets a rebuild to end on
+    applySeq.registerChangeCallback([this](int32_t) { invalidate(RIBBON); });
+
+    // h arrives from the network on renderers, so each node keeps its own
+    // history; a single thread writes it
+    for (auto& value : hHistory) value.store(0, std::memory_order_relaxed);
+    p[1].registerChangeCallback([this](float value) {
+      int head = hHead.load(std::memory_order_relaxed);
+      hHistory[head % kHistory].store(value, std::memory_order_relaxed);
+      hHead.store(head + 1, std::memory_order_release);
+    });
+    captureA.registerChangeCallback([this](bool) { requestCapture(Morph::A); });
+    captureB.registerChangeCallback([this](bool) { requestCapture(Morph::B); });
+
+    // morph storage is sized for the largest N up front, the mesh for the
+    // enabled modes in warm()
+    shapes.reserve((int)p[0].max() + 1);
+    blended.reserve(3 * ((int)p[0].max() + 1));
+  }
+
+  // Creates the GPU buffers at full size for the enabled modes so a pooled
+  // voice can be triggered mid-show without allocating; needs a current GL
+  // context. Call again after recalling the show's first preset.
+  void warm() {
+    reserve();
+    system.reset();
+    system.primitive(Mesh::TRIANGLE_STRIP);
+    system.vertices().resize(vertexCapacity());
+    system.normals().resize(vertexCapacity());
+    system.indices().resize(indexCapacity());
+    system.update();
+    system.indices().clear();
+    tubeCount = tubeCountSides = tubeCountSystems = 0;
+    invalidate(INTEGRATE);
+  }
+
+  void onTriggerOn() override { invalidate(INTEGRATE); }
+
+  // FrameArena bytes one compute() takes at most: ribbon faces and
+  // audioWidth widths
+  size_t scratchBytes() {
+    size_t points = (size_t)p[0].max() + 1;
+    return (3 * 2 + 1) * points * sizeof(float) + 2 * FrameArena::kAlignment;
+  }
+
+  void invalidate(int stages) { dirty.fetch_or(stages); }
+
+  // captures the current trajectory as a morph end on every node
+  void capture(Morph::End end) {
+    (end == Morph::A ? captureA : captureB).trigger();
+  }
+
+  // takes the trajectory as it is at the next compute() as a morph end
+  void requestCapture(Morph::End end) {
+    captures.fetch_or(end);
+    invalidate(RIBBON);
+  }
+
+  // registered parameter with the given name, nullptr if there is none
+  ParameterMeta* parameter(const std::string& name) {
+    for (auto* param : parameters()) {
+      if (param->getName() == name) return param;
+    }
+    return nullptr;
+  }
+
+  int steps() { return (int)p[0]; }
+
+  // number of times compute() changed the mesh
+  uint64_t rebuilds() const { return rebuildCount; }
+
+  // primary: numbers the command just performed, after its parameters
+  void markApplied(int seq) { applySeq = seq; }
+
+  // the last command number the mesh has been rebuilt with
+  int appliedSeq() const { return consumedSeq; }
+
+  // command numbering rather than something to show or store in presets
+  bool bookkeeping(const ParameterMeta* param) const { return param == &applySeq; }
+
+  void setMode(int desiredMode) {
+    this->mode = desiredMode;
+  }
+
+  void toggleLight() {
+    this->light = !this->light;
+  }
+
+  void update(double /*dt*/) override {
+    if (compute()) {
+      system.update();
+    }
+    if (flowTraced) {
+      flow.mesh().update();
+      flowTraced = false;
+    }
+    if (particles) {
+      advect();
+      cloud.mesh().update();
+    }
+  }
+
+  // steps the particle cloud on every core, returning how many particles
+  // diverged and were reseeded; safe without a GL context. The cloud is
+  // allocated by reserve(), or here when stepped headless.
+  int advect() {
+    if (!cloud.count()) cloud.resize(kParticles, D);
+    float params[P];
+    values(params);
+    return cloud.advance(mode, params, kParticleSteps, kEscape);
+  }
+
+  int particleCount() { return cloud.count(); }
+
+  int streamlineCount() { return flow.count(); }
+
+  // vertices onProcess draws
+  int vertexCount() {
+    int count = particles ? cloud.count() : (int)system.vertices().size();
+    if (streamlines) count += (int)flow.mesh().vertices().size();
+    return count;
+  }
+
+  // copies the mesh as last computed, or the raw integrated trajectories,
+  // into out for the Exporter; reuses out's storage
+  void snapshot(MeshSnapshot& out, bool trajectory) {
+    out.normals.clear();
+    out.indices.clear();
+    if (trajectory) {
+      out.primitive = MeshSnapshot::POLYLINES;
+      out.polylines = trajectories;
+      out.vertices.assign(points.begin(), points.end());
+      return;
+    }
+    auto& vertices = system.vertices();
+    auto& normals = system.normals();
+    out.primitive = system.primitive() == Mesh::TRIANGLES
+                        ? MeshSnapshot::TRIANGLES
+                        : MeshSnapshot::TRIANGLE_STRIP;
+    out.vertices.resize(3 * vertices.size());
+    out.normals.resize(3 * normals.size());
+    if (vertices.size()) std::copy_n(floats(vertices), out.vertices.size(), out.vertices.data());
+    if (normals.size()) std::copy_n(floats(normals), out.normals.size(), out.normals.data());
+    out.indices.assign(system.indices().begin(), system.indices().end());
+  }
+
+  // reruns the invalidated stages on the CPU, returning whether the mesh
+  // changed; safe without a GL context
+  bool compute() {
+    // read before taking the stages: once the number is visible, so are
+    // the invalidations of the parameters sent ahead of it
+    int seq = applySeq;
+    int stages = dirty.exchange(0);
+    auto& metrics = Metrics::local();
+    if (!stages) {
+      metrics.add(Metrics::MESH_CACHE_HITS);
+      return false;
+    }
+    reserve();  // no-op unless a mode was just switched on
+
+    // integration only happens at the morph's ends, so parameter changes
+    // wait until it is back at 0
+    if (morphing()) {
+      deferred |= stages & INTEGRATE;
+      stages &= ~INTEGRATE;
+    } else {
+      stages |= deferred;
+      deferred = 0;
+    }
+
+    if (stages & INTEGRATE) {
+      int n = (int)p[0];
+      float params[P];
+      values(params);
+
+      // Euler's method from the initial conditions, see KernelsImpl.hpp;
+      // coupled copies start spaced along x and step together in SIMD lanes
+      trajectories = coupled;
+      metrics.add(Metrics::INTEGRATION_STEPS, uint64_t(n) * trajectories);
+      points.resize(3 * (n + 1) * trajectories);
+      for (int k = 0; k < trajectories; k++) {
+        float* start = points.data() + 3 * (n + 1) * k;
+        start[0] = p[2] + kCoupledOffset * k;
+        start[1] = p[3];
+        start[2] = p[4];
+      }
+      if (trajectories == 1) {
+        kernels().integrate(mode, params, n, points.data());
+      } else {
+        kernels().integrateCoupled(mode, params, trajectories, n, coupling,
+                                   points.data());
+      }
+
+      if (streamlines) {
+        flow.trace(mode, params, streamGrid, streamSteps, D, kEscape);
+        flowTraced = true;
+      }
+    }
+
+    // the first system stands in for all of them when capturing and morphing
+    int systems = trajectories;
+    int count = (int)points.size() / 3 / systems;
+    if (int ends = captures.exchange(0)) {
+      if (ends & Morph::A) shapes.capture(Morph::A, points.data(), count);
+      if (ends & Morph::B) shapes.capture(Morph::B, points.data(), count);
+    }
+
+    // RIBBON, also after INTEGRATE
+    const float* curve = points.data();
+    if (morphing()) {
+      count = shapes.count();
+      blended.resize(3 * count);
+      shapes.blend(morph, blended.data());
+      curve = blended.data();
+      systems = 1;
+    }
+    const float* widths = audioWidth ? audioWidths(count) : nullptr;
+    if (int n = sides()) {
+      // tube normals come out of the frames, no face pass needed
+      system.primitive(Mesh::TRIANGLES);
+      system.vertices().resize(n * count * systems);
+      system.normals().resize(n * count * systems);
+      tubeIndices(count, n, systems);
+      for (int k = 0; k < systems; k++) {
+        kernels().tube(curve + 3 * count * k, count, width, widths, n,
+                       floats(system.vertices()) + 3 * n * count * k,
+                       floats(system.normals()) + 3 * n * count * k);
+      }
+    } else {
+      // one strip, each system's ribbon joined to the next by two
+      // degenerate vertices
+      int block = 2 * count + 2;
+      system.primitive(Mesh::TRIANGLE_STRIP);
+      system.vertices().resize(block * systems - 2);
+      system.normals().resize(block * systems - 2);
+      tubeIndices(0, 0, 0);
+      float* faces = FrameArena::local().allocate<float>(3 * 2 * count);
+      for (int k = 0; k < systems; k++) {
+        float* vertices = floats(system.vertices()) + 3 * block * k;
+        kernels().ribbon(curve + 3 * count * k, count, width, widths,
+                         vertices);
+        kernels().stripNormals(vertices, 2 * count, faces,
+                               floats(system.normals()) + 3 * block * k);
+      }
+      for (int k = 0; k + 1 < systems; k++) {
+        copyVertex(block * k + 2 * count - 1, block * k + 2 * count);
+        copyVertex(block * (k + 1), block * k + 2 * count + 1);
+      }
+    }
+    if (!(stages & INTEGRATE)) metrics.add(Metrics::INTEGRATION_REUSES);
+    metrics.add(Metrics::MESH_REBUILDS);
+    rebuildCount++;
+    consumedSeq = seq;
+    return true;
+  }
+
+  void onProcess(Graphics& g) override {
+    g.depthTesting(light);
+    g.lighting(light);
+    g.blendTrans();
+    g.color(1);
+    g.scale(0.1);
+    if (particles) {
+      g.draw(cloud.mesh());
+    } else {
+      g.draw(system);
+    }
+    if (streamlines && flow.count()) {
+      g.lighting(false);
+      g.color(1, 1, 1, 0.25);
+      g.draw(flow.mesh());
+    }
+  }
+};
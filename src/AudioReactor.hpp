@@ -0,0 +1,92 @@
+// Audio path of the primary: follows the envelope of input 0 and copies the
+// inputs to every output pair ("multi-stereo"). The app's onSound is
+// prepareThread() and callback(), so bench --rt-check runs exactly what the
+// app does. callback() runs on the audio thread and must stay real-time safe (no allocation, locks or I/O, see
+// RealtimeSafety.hpp), so the envelope is only published through an atomic
+// and the render thread applies it to the Attractor. Denormals are kept
+// out twice: the Vactrol snaps its decaying state to 0, and the audio
+// thread flushes them where the CPU can (see Denormals.hpp).
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include "al/io/al_AudioIO.hpp"
+#include "Denormals.hpp"
+#include "Kernels.hpp"
+#include "Metrics.hpp"
+#include "RealtimeSafety.hpp"
+#include "ThreadTuning.hpp"
+#include "Vactrol.hpp"
+using namespace al;
+
+class AudioReactor {
+public:
+  explicit AudioReactor(double sampleRate) : mVactrol(sampleRate) {}
+
+  // rate the stream actually runs at; on the audio thread, before process()
+  void setSampleRate(double sampleRate) { mVactrol.setSampleRate(sampleRate); }
+
+  // sets up the calling thread on the first call only: thread role, stack,
+  // denormal flushing, metrics shard, kernel dispatch and the stream's own
+  // sample rate (so the envelope's time constants hold on 48 kHz hardware
+  // too). Not real-time safe, so it runs before the first callback() on
+  // every node.
+  void prepareThread(AudioIOData& io) {
+    if (mThreadPrepared) return;
+    ThreadTuning::get().apply(ThreadTuning::AUDIO);
+    ThreadTuning::prefaultStack();
+    flushDenormals();
+    Metrics::local();  // registers the thread's shard
+    kernels();         // picks the ISA on first use, which allocates
+    if (io.framesPerSecond() > 0) setSampleRate(io.framesPerSecond());
+    mThreadPrepared = true;
+  }
+
+  // one audio callback on the primary: process() timed into the metrics,
+  // all inside the real-time section
+  void callback(AudioIOData& io) {
+    RealtimeScope realtime;
+    auto start = std::chrono::steady_clock::now();
+    process(io);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+    auto& metrics = Metrics::local();
+    metrics.add(Metrics::AUDIO_CALLBACKS);
+    metrics.record(Metrics::AUDIO_LOAD,
+                   seconds * io.framesPerSecond() / io.framesPerBuffer());
+  }
+
+  void process(AudioIOData& io) {
+    const int frames = io.framesPerBuffer();
+
+    // envelope of input 0, a block at a time
+    for (int start = 0; start < frames; start += kBlock) {
+      int n = frames - start < kBlock ? frames - start : kBlock;
+      kernels().rectify(io.inBuffer(0) + start, n, mEnvelope);
+      for (int i = 0; i < n; i++) {
+        mEnvelope[i] = mVactrol(mEnvelope[i]);
+      }
+      // "double warp", mapped to the range of h
+      kernels().warp(mEnvelope, n, 0.007f);
+      mLevel.store(mEnvelope[n - 1], std::memory_order_relaxed);
+    }
+
+    // "multi-stereo" output
+    for (auto channel = 0; channel < io.channelsOut(); channel++) {
+      const float* in = io.inBuffer(channel % 2);
+      std::copy(in, in + frames, io.outBuffer(channel));
+    }
+  }
+
+  // latest envelope value, already in the range of h
+  float level() const { return mLevel.load(std::memory_order_relaxed); }
+
+private:
+  static const int kBlock = 256;
+  Vactrol mVactrol;
+  float mEnvelope[kBlock];
+  std::atomic<float> mLevel{0};
+  bool mThreadPrepared = false;  // only touched by the audio thread
+};
@@ -0,0 +1,30 @@
+// Flush-to-zero / denormals-are-zero for the calling thread. Filter state
+// decaying towards zero turns denormal on silence, and x86 handles those
+// in microcode at up to ~100x the cost of a normal multiply. The setting is
+// per thread, so the audio thread enables it on its first callback. Targets
+// with neither MXCSR nor FPCR get nothing from it, so filter state snaps
+// itself to 0 as well (see Vactrol.hpp).
+
+#pragma once
+
+#include <cstdint>
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define ALLOSKETCH_MXCSR
+#endif
+
+// enables (or disables) FTZ and DAZ for the calling thread
+inline void flushDenormals(bool enable = true) {
+#if defined(ALLOSKETCH_MXCSR)
+  const unsigned bits = 0x8040;  // FTZ (bit 15) | DAZ (bit 6)
+  _mm_setcsr(enable ? _mm_getcsr() | bits : _mm_getcsr() & ~bits);
+#elif defined(__aarch64__)
+  // FPCR.FZ (bit 24) flushes both inputs and results
+  uint64_t fpcr;
+  __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+  fpcr = enable ? fpcr | (1ull << 24) : fpcr & ~(1ull << 24);
+  __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#else
+  (void)enable;
+#endif
+}
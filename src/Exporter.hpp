@@ -0,0 +1,273 @@
+// Writes attractor geometry to PLY, OBJ or glTF on a background thread.
+// The render thread only copies a snapshot into recycled buffers (see
+// Attractor::snapshot) and queues it, so large exports never stall a frame
+// or the audio. Binary output assumes a little-endian host.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// geometry as the Attractor last built it; strips and polylines are
+// turned into indexed triangles and segments on the I/O thread
+struct MeshSnapshot {
+  enum Primitive { TRIANGLES, TRIANGLE_STRIP, POLYLINES };
+  std::string path;  // without extension
+  Primitive primitive = TRIANGLES;
+  int polylines = 1;  // POLYLINES: vertices split evenly between this many
+  std::vector<float> vertices;  // xyz
+  std::vector<float> normals;   // xyz, empty for trajectories
+  std::vector<uint32_t> indices;  // TRIANGLES only, until indexed
+};
+
+class Exporter {
+public:
+  // format is "ply", "obj" or "gltf", as checked by Options
+  explicit Exporter(const std::string& format) : mFormat(format) {
+    mThread = std::thread([this]() { run(); });
+  }
+
+  // writes everything still queued, then stops
+  ~Exporter() {
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mStop = true;
+    }
+    mWake.notify_all();
+    mThread.join();
+  }
+
+  // an empty snapshot whose buffers are reused from earlier exports
+  std::unique_ptr<MeshSnapshot> acquire() {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mFree.empty()) return std::unique_ptr<MeshSnapshot>(new MeshSnapshot);
+    auto snapshot = std::move(mFree.back());
+    mFree.pop_back();
+    return snapshot;
+  }
+
+  void submit(std::unique_ptr<MeshSnapshot> snapshot) {
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mQueue.push_back(std::move(snapshot));
+    }
+    mWake.notify_all();
+  }
+
+private:
+  void run() {
+    while (true) {
+      std::unique_ptr<MeshSnapshot> snapshot;
+      {
+        std::unique_lock<std::mutex> lock(mLock);
+        mWake.wait(lock, [this]() { return mStop || !mQueue.empty(); });
+        if (mQueue.empty()) return;
+        snapshot = std::move(mQueue.front());
+        mQueue.erase(mQueue.begin());
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::string path = snapshot->path + "." + mFormat;
+      bool finite = std::all_of(snapshot->vertices.begin(), snapshot->vertices.end(),
+                                [](float value) { return std::isfinite(value); });
+      bool written = false;
+      if (finite) {
+        index(*snapshot);
+        written = mFormat == "obj"    ? writeObj(*snapshot, path)
+                  : mFormat == "gltf" ? writeGltf(*snapshot, path)
+                                      : writePly(*snapshot, path);
+      }
+      double ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start).count();
+      if (!finite) {
+        // nan/inf would make invalid OBJ and glTF (accessor bounds)
+        std::cerr << "Not exporting " << path
+                  << ": the attractor diverged (non-finite vertices)" << std::endl;
+      } else if (written) {
+        std::cout << "Exported " << path << " (" << snapshot->vertices.size() / 3
+                  << " vertices) in " << ms << " ms" << std::endl;
+      } else {
+        std::cerr << "Couldn't write " << path << std::endl;
+      }
+
+      std::lock_guard<std::mutex> lock(mLock);
+      mFree.push_back(std::move(snapshot));
+    }
+  }
+
+  // rewrites strips as triangles and polylines as segments
+  static void index(MeshSnapshot& mesh) {
+    uint32_t count = (uint32_t)(mesh.vertices.size() / 3);
+    if (mesh.primitive == MeshSnapshot::TRIANGLE_STRIP) {
+      mesh.indices.clear();
+      const float* v = mesh.vertices.data();
+      for (uint32_t i = 0; i + 2 < count; i++) {
+        // every other triangle flips to keep the winding; degenerate ones
+        // (the joins between coupled ribbons) are dropped
+        uint32_t a = i, b = i + 1, c = i + 2;
+        if (i & 1) std::swap(a, b);
+        if (same(v, a, b) || same(v, b, c) || same(v, a, c)) continue;
+        mesh.indices.insert(mesh.indices.end(), {a, b, c});
+      }
+      mesh.primitive = MeshSnapshot::TRIANGLES;
+    } else if (mesh.primitive == MeshSnapshot::POLYLINES) {
+      mesh.indices.clear();
+      uint32_t length = mesh.polylines > 0 ? count / mesh.polylines : 0;
+      for (int k = 0; k < mesh.polylines; k++) {
+        for (uint32_t i = 1; i < length; i++) {
+          uint32_t at = k * length + i;
+          mesh.indices.insert(mesh.indices.end(), {at - 1, at});
+        }
+      }
+    }
+  }
+
+  static bool same(const float* v, uint32_t a, uint32_t b) {
+    return v[3 * a] == v[3 * b] && v[3 * a + 1] == v[3 * b + 1] &&
+           v[3 * a + 2] == v[3 * b + 2];
+  }
+
+  static bool lines(const MeshSnapshot& mesh) {
+    return mesh.primitive == MeshSnapshot::POLYLINES;
+  }
+
+  static int perPrimitive(const MeshSnapshot& mesh) {
+    return lines(mesh) ? 2 : 3;
+  }
+
+  static bool writePly(const MeshSnapshot& mesh, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    size_t count = mesh.vertices.size() / 3;
+    size_t primitives = mesh.indices.size() / perPrimitive(mesh);
+    bool normals = !mesh.normals.empty();
+    out << "ply\nformat binary_little_endian 1.0\nelement vertex " << count
+        << "\nproperty float x\nproperty float y\nproperty float z\n";
+    if (normals) {
+      out << "property float nx\nproperty float ny\nproperty float nz\n";
+    }
+    if (lines(mesh)) {
+      out << "element edge " << primitives
+          << "\nproperty int vertex1\nproperty int vertex2\n";
+    } else {
+      out << "element face " << primitives
+          << "\nproperty list uchar uint vertex_indices\n";
+    }
+    out << "end_header\n";
+
+    for (size_t i = 0; i < count; i++) {
+      out.write((const char*)&mesh.vertices[3 * i], 3 * sizeof(float));
+      if (normals) out.write((const char*)&mesh.normals[3 * i], 3 * sizeof(float));
+    }
+    const unsigned char corners = 3;
+    for (size_t i = 0; i < primitives; i++) {
+      if (!lines(mesh)) out.write((const char*)&corners, 1);
+      out.write((const char*)&mesh.indices[perPrimitive(mesh) * i],
+                perPrimitive(mesh) * sizeof(uint32_t));
+    }
+    return (bool)out;
+  }
+
+  static bool writeObj(const MeshSnapshot& mesh, const std::string& path) {
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) return false;
+    size_t count = mesh.vertices.size() / 3;
+    const float* v = mesh.vertices.data();
+    for (size_t i = 0; i < count; i++, v += 3) {
+      std::fprintf(out, "v %g %g %g\n", v[0], v[1], v[2]);
+    }
+    const float* n = mesh.normals.data();
+    for (size_t i = 0; i < mesh.normals.size() / 3; i++, n += 3) {
+      std::fprintf(out, "vn %g %g %g\n", n[0], n[1], n[2]);
+    }
+    // OBJ indices are 1-based
+    const uint32_t* index = mesh.indices.data();
+    for (size_t i = 0; i < mesh.indices.size() / perPrimitive(mesh); i++) {
+      if (lines(mesh)) {
+        std::fprintf(out, "l %u %u\n", index[0] + 1, index[1] + 1);
+        index += 2;
+      } else {
+        std::fprintf(out, "f %u//%u %u//%u %u//%u\n", index[0] + 1, index[0] + 1,
+                     index[1] + 1, index[1] + 1, index[2] + 1, index[2] + 1);
+        index += 3;
+      }
+    }
+    return std::fclose(out) == 0;
+  }
+
+  // .gltf JSON next to a .bin with positions, normals and indices
+  static bool writeGltf(const MeshSnapshot& mesh, const std::string& path) {
+    std::string binPath = path.substr(0, path.size() - 5) + ".bin";
+    std::string binName = binPath.substr(binPath.find_last_of("/\\") + 1);
+    size_t count = mesh.vertices.size() / 3;
+    size_t positionBytes = mesh.vertices.size() * sizeof(float);
+    size_t normalBytes = mesh.normals.size() * sizeof(float);
+    size_t indexBytes = mesh.indices.size() * sizeof(uint32_t);
+
+    std::ofstream bin(binPath, std::ios::binary);
+    bin.write((const char*)mesh.vertices.data(), positionBytes);
+    bin.write((const char*)mesh.normals.data(), normalBytes);
+    bin.write((const char*)mesh.indices.data(), indexBytes);
+    if (!bin) return false;
+
+    // POSITION needs its bounds
+    float low[3] = {0, 0, 0}, high[3] = {0, 0, 0};
+    for (size_t i = 0; i < count; i++) {
+      for (int k = 0; k < 3; k++) {
+        float value = mesh.vertices[3 * i + k];
+        low[k] = i ? std::min(low[k], value) : value;
+        high[k] = i ? std::max(high[k], value) : value;
+      }
+    }
+
+    bool normals = normalBytes > 0;
+    int indexView = normals ? 2 : 1;
+    std::ofstream json(path);
+    json.precision(9);  // bounds must hold the float positions exactly
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"AlloSketch\"},"
+         << "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+         << "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0"
+         << (normals ? ",\"NORMAL\":1" : "") << "},\"indices\":" << indexView
+         << ",\"mode\":" << (lines(mesh) ? 1 : 4) << "}]}],"
+         << "\"buffers\":[{\"uri\":\"" << binName << "\",\"byteLength\":"
+         << positionBytes + normalBytes + indexBytes << "}],"
+         << "\"bufferViews\":[{\"buffer\":0,\"byteLength\":" << positionBytes
+         << ",\"target\":34962}";
+    if (normals) {
+      json << ",{\"buffer\":0,\"byteOffset\":" << positionBytes
+           << ",\"byteLength\":" << normalBytes << ",\"target\":34962}";
+    }
+    json << ",{\"buffer\":0,\"byteOffset\":" << positionBytes + normalBytes
+         << ",\"byteLength\":" << indexBytes << ",\"target\":34963}],"
+         << "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":"
+         << count << ",\"type\":\"VEC3\",\"min\":[" << low[0] << "," << low[1]
+         << "," << low[2] << "],\"max\":[" << high[0] << "," << high[1] << ","
+         << high[2] << "]}";
+    if (normals) {
+      json << ",{\"bufferView\":1,\"componentType\":5126,\"count\":" << count
+           << ",\"type\":\"VEC3\"}";
+    }
+    json << ",{\"bufferView\":" << indexView
+         << ",\"componentType\":5125,\"count\":" << mesh.indices.size()
+         << ",\"type\":\"SCALAR\"}]}\n";
+    return (bool)json;
+  }
+
+  std::string mFormat;
+  std::thread mThread;
+  std::mutex mLock;
+  std::condition_variable mWake;
+  std::vector<std::unique_ptr<MeshSnapshot>> mQueue;  // oldest first
+  std::vector<std::unique_ptr<MeshSnapshot>> mFree;   // written, for reuse
+  bool mStop = false;
+};
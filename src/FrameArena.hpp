@@ -0,0 +1,87 @@
+// Per-thread bump allocator for scratch data that only lives for one frame.
+// reset() at the end of the frame makes all of it reusable, so steady-state
+// frames never touch the heap. An allocation that doesn't fit falls back to
+// the heap and the arena grows to the frame's high-water mark at the next
+// reset, between frames.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+class FrameArena {
+public:
+  static const size_t kAlignment = 64;  // one cache line
+
+  // the calling thread's arena
+  static FrameArena& local() {
+    static thread_local FrameArena arena;
+    return arena;
+  }
+
+  ~FrameArena() { freeOverflow(); }
+
+  // uninitialized storage for count T, valid until the next reset()
+  template <class T>
+  T* allocate(size_t count) {
+    size_t bytes = (count * sizeof(T) + kAlignment - 1) & ~(kAlignment - 1);
+    mUsed += bytes;
+    if (mOffset + bytes <= mCapacity) {
+      void* memory = mMemory + mOffset;
+      mOffset += bytes;
+      return static_cast<T*>(memory);
+    }
+
+    void* memory = std::malloc(bytes);
+    mOverflow.push_back(memory);
+    mOverflows++;
+    return static_cast<T*>(memory);
+  }
+
+  // ends the frame, growing if it overflowed
+  void reset() {
+    mLastFrameBytes = mUsed;
+    mPeakBytes = std::max(mPeakBytes, mUsed);
+    if (!mOverflow.empty()) {
+      freeOverflow();
+      reserve(mUsed);
+    }
+    mUsed = mOffset = 0;
+  }
+
+  // grows to at least bytes, touching every page so it is resident
+  void reserve(size_t bytes) {
+    if (bytes <= mCapacity) return;
+    mCapacity = (bytes + (bytes >> 2) + kAlignment - 1) & ~(kAlignment - 1);
+    mStorage.reset(new unsigned char[mCapacity + kAlignment]);
+    size_t misalignment = reinterpret_cast<size_t>(mStorage.get()) % kAlignment;
+    mMemory = mStorage.get() + (misalignment ? kAlignment - misalignment : 0);
+    std::memset(mMemory, 0, mCapacity);
+  }
+
+  size_t capacity() const { return mCapacity; }
+  size_t bytesThisFrame() const { return mUsed; }
+  size_t lastFrameBytes() const { return mLastFrameBytes; }
+  size_t peakBytes() const { return mPeakBytes; }
+  size_t overflows() const { return mOverflows; }  // heap fallbacks so far
+
+private:
+  void freeOverflow() {
+    for (void* memory : mOverflow) std::free(memory);
+    mOverflow.clear();
+  }
+
+  std::unique_ptr<unsigned char[]> mStorage;
+  unsigned char* mMemory = nullptr;
+  size_t mCapacity = 0;
+  size_t mOffset = 0;
+  size_t mUsed = 0;
+  size_t mLastFrameBytes = 0;
+  size_t mPeakBytes = 0;
+  size_t mOverflows = 0;
+  std::vector<void*> mOverflow;
+};
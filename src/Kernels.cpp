@@ -0,0 +1,75 @@
+#include "Kernels.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(ALLOSKETCH_X86_KERNELS)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace kernels_generic { extern const Kernels table; }
+#ifdef ALLOSKETCH_X86_KERNELS
+namespace kernels_avx2 { extern const Kernels table; }
+namespace kernels_avx512 { extern const Kernels table; }
+#endif
+
+namespace {
+
+#ifdef ALLOSKETCH_X86_KERNELS
+#ifdef _MSC_VER
+// CPUID feature bits plus the OS having enabled the matching register state
+bool cpuHasAvx2() {
+  int info[4];
+  __cpuid(info, 1);
+  bool osxsave = info[2] & (1 << 27), avx = info[2] & (1 << 28),
+       fma = info[2] & (1 << 12);
+  if (!(osxsave && avx && fma) || (_xgetbv(0) & 0x6) != 0x6) return false;
+  __cpuidex(info, 7, 0);
+  return info[1] & (1 << 5);
+}
+
+bool cpuHasAvx512() {
+  if (!cpuHasAvx2() || (_xgetbv(0) & 0xE6) != 0xE6) return false;
+  int info[4];
+  __cpuidex(info, 7, 0);
+  return info[1] & (1 << 16);
+}
+#else
+bool cpuHasAvx2() {
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+bool cpuHasAvx512() {
+  return cpuHasAvx2() && __builtin_cpu_supports("avx512f");
+}
+#endif
+#endif
+
+const Kernels* selectKernels() {
+  auto supported = supportedKernels();
+  const Kernels* selected = supported.back();
+
+  if (const char* forced = std::getenv("ALLOSKETCH_ISA")) {
+    for (auto* variant : supported) {
+      if (!std::strcmp(variant->isa, forced)) selected = variant;
+    }
+  }
+  return selected;
+}
+
+}  // namespace
+
+std::vector<const Kernels*> supportedKernels() {
+  std::vector<const Kernels*> supported{&kernels_generic::table};
+#ifdef ALLOSKETCH_X86_KERNELS
+  if (cpuHasAvx2()) supported.push_back(&kernels_avx2::table);
+  if (cpuHasAvx512()) supported.push_back(&kernels_avx512::table);
+#endif
+  return supported;
+}
+
+const Kernels& kernels() {
+  static const Kernels* selected = selectKernels();
+  return *selected;
+}
@@ -0,0 +1,64 @@
+// Hot loops of the attractor pipeline and the audio envelope chain. Each is
+// compiled once per ISA (Kernels_*.cpp, flags set in CMakeLists.txt) and the
+// best variant for the running CPU is picked on first use.
+
+#pragma once
+
+#include <vector>
+
+static const int kMaxTubeSides = 16;
+static const int kMaxCoupled = 8;  // one SIMD lane per system on AVX2
+
+struct Kernels {
+  const char* isa;
+
+  // n Euler steps of attractor `mode` starting from points[0..2], writing
+  // n + 1 xyz points; params are the Attractor's p[] values
+  void (*integrate)(int mode, const float* params, int n, float* points);
+
+  // n Euler steps of k <= kMaxCoupled copies of attractor `mode`, each also
+  // pulled towards their mean state by `coupling` (diffusive, all to all).
+  // System j starts from and writes its n + 1 points at
+  // points + 3 * (n + 1) * j. With coupling 0 each matches integrate as
+  // long as all k stay finite
+  void (*integrateCoupled)(int mode, const float* params, int k, int n,
+                           float coupling, float* points);
+
+  // `steps` Euler steps of attractor `mode` for n particles stored as
+  // separate x, y and z arrays. Particles then outside [-bound, bound]^3
+  // (or NaN) are reseeded in [-reseed, reseed]^3 from a hash of seed + i;
+  // returns how many were
+  int (*advect)(int mode, const float* params, int steps, int n, float* x,
+                float* y, float* z, float bound, float reseed, unsigned seed);
+
+  // expands n xyz points into a 2n vertex triangle strip like
+  // Mesh::ribbonize(width, true): each point is offset by -+width along its
+  // Frenet normal, so the strip faces the binormal; widths, unless null,
+  // gives the width of every point instead
+  void (*ribbon)(const float* points, int n, float width, const float* widths,
+                 float* vertices);
+
+  // ring of `sides` (<= kMaxTubeSides) vertices around each of n xyz
+  // points, oriented by parallel-transport frames found in one pass along
+  // the curve; writes n * sides vertices and their unit normals. radii,
+  // unless null, gives the radius of every point instead
+  void (*tube)(const float* points, int n, float radius, const float* radii,
+               int sides, float* vertices, float* normals);
+
+  // area-weighted vertex normals of an n vertex triangle strip; faces is
+  // scratch space for 3 * (n - 2) floats
+  void (*stripNormals)(const float* vertices, int n, float* faces,
+                       float* normals);
+
+  // envelope chain stages: |in|, then the "double warp" curve
+  // scale * sqrt(log10(9x + 1)) in place
+  void (*rectify)(const float* in, int n, float* out);
+  void (*warp)(float* envelope, int n, float scale);
+};
+
+// variant used by the app, chosen from CPUID; ALLOSKETCH_ISA=generic|avx2|
+// avx512 in the environment forces a lower one
+const Kernels& kernels();
+
+// every variant the running CPU can execute, generic first
+std::vector<const Kernels*> supportedKernels();
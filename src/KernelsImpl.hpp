@@ -0,0 +1,332 @@
+// Kernel bodies, included once per ISA by Kernels_*.cpp with KERNEL_NS set.
+// Everything here has internal linkage so inline code compiled for one ISA
+// can never be shared with another variant by the linker.
+
+#include <math.h>
+#include "Kernels.hpp"
+
+#if !defined(KERNEL_NS) || !defined(KERNEL_ISA)
+#error "define KERNEL_NS and KERNEL_ISA before including KernelsImpl.hpp"
+#endif
+
+namespace KERNEL_NS {
+namespace {
+
+// the four vector fields; parameter names as in Attractor.hpp
+struct Allotsucs {
+  // based on the Den Tsucs Attractor by Paul Bourke
+  float a, c, e, o;
+  explicit Allotsucs(const float* p) : a(p[8]), c(p[10]), e(p[12]), o(p[14]) {}
+  void operator()(float x, float y, float z, float& fx, float& fy, float& fz) const {
+    fx = a * (y - x) + x * z;
+    fy = o * y - x * z;
+    fz = c * z + x * y - e * x * x;
+  }
+};
+
+struct Lorenz {
+  float rho, sigma, beta;
+  explicit Lorenz(const float* p) : rho(p[5]), sigma(p[6]), beta(p[7]) {}
+  void operator()(float x, float y, float z, float& fx, float& fy, float& fz) const {
+    fx = sigma * (y - x);
+    fy = x * (rho - z) - y;
+    fz = x * y - beta * z;
+  }
+};
+
+struct Allorenz {
+  float rho, sigma, beta;
+  explicit Allorenz(const float* p) : rho(p[5]), sigma(p[6]), beta(p[7]) {}
+  void operator()(float x, float y, float z, float& fx, float& fy, float& fz) const {
+    fx = y * z;
+    fy = rho * (x - y);
+    fz = sigma - beta * x * y - (1 - beta) * x * x;
+  }
+};
+
+struct ChenLee {
+  // Allorenz. Based on the Chen - Lee Attractor
+  float a, b, d;
+  explicit ChenLee(const float* p) : a(p[8]), b(p[9]), d(p[11]) {}
+  void operator()(float x, float y, float z, float& fx, float& fy, float& fz) const {
+    fx = a * x - y * z;
+    fy = y * b + x * z;
+    fz = d * z + x * y / 3;
+  }
+};
+
+// calls run with the field of the given mode, so every loop below is
+// instantiated (and vectorized) once per field
+template <class Run>
+void withField(int mode, const float* params, Run run) {
+  if (mode == 0) {
+    run(Allotsucs(params));
+  } else if (mode == 1) {
+    run(Lorenz(params));
+  } else if (mode == 2) {
+    run(Allorenz(params));
+  } else {
+    run(ChenLee(params));
+  }
+}
+
+template <class Field>
+void integrateField(const Field& f, float h, int n, float* __restrict points) {
+  float x = points[0], y = points[1], z = points[2];
+  float* out = points + 3;
+  for (int i = 0; i < n; i++, out += 3) {
+    float fx, fy, fz;
+    f(x, y, z, fx, fy, fz);
+    out[0] = x += h * fx;
+    out[1] = y += h * fy;
+    out[2] = z += h * fz;
+  }
+}
+
+void integrate(int mode, const float* params, int n, float* points) {
+  withField(mode, params, [&](const auto& field) {
+    integrateField(field, params[1], n, points);
+  });
+}
+
+template <class Field>
+void integrateCoupledField(const Field& f, float h, int k, int n,
+                           float coupling, float* __restrict points) {
+  // one lane per system; all kMaxCoupled lanes are stepped so the lane
+  // loops have a fixed width, and unused lanes weigh 0 in the mean
+  const int stride = 3 * (n + 1);
+  float x[kMaxCoupled], y[kMaxCoupled], z[kMaxCoupled], weight[kMaxCoupled];
+  for (int j = 0; j < kMaxCoupled; j++) {
+    const float* start = points + stride * (j < k ? j : 0);
+    x[j] = start[0], y[j] = start[1], z[j] = start[2];
+    weight[j] = j < k ? 1.f / k : 0;
+  }
+
+  for (int i = 1; i <= n; i++) {
+    float mx = 0, my = 0, mz = 0;
+    for (int j = 0; j < kMaxCoupled; j++) {
+      mx += weight[j] * x[j];
+      my += weight[j] * y[j];
+      mz += weight[j] * z[j];
+    }
+    // fully unrolled, this loop is no longer vectorized as one
+#ifdef __GNUC__
+#pragma GCC unroll 1
+#endif
+    for (int j = 0; j < kMaxCoupled; j++) {
+      float fx, fy, fz;
+      f(x[j], y[j], z[j], fx, fy, fz);
+      x[j] += h * (fx + coupling * (mx - x[j]));
+      y[j] += h * (fy + coupling * (my - y[j]));
+      z[j] += h * (fz + coupling * (mz - z[j]));
+    }
+    for (int j = 0; j < k; j++) {
+      float* out = points + stride * j + 3 * i;
+      out[0] = x[j], out[1] = y[j], out[2] = z[j];
+    }
+  }
+}
+
+void integrateCoupled(int mode, const float* params, int k, int n,
+                      float coupling, float* points) {
+  withField(mode, params, [&](const auto& field) {
+    integrateCoupledField(field, params[1], k, n, coupling, points);
+  });
+}
+
+// uniform in [-1, 1) from a 32 bit hash of i
+inline float hashUnit(unsigned i) {
+  i = (i ^ 0x9e3779b9u) * 2654435761u;
+  i ^= i >> 16;
+  i *= 2246822519u;
+  i ^= i >> 13;
+  return (i >> 8) * (2.f / 16777216) - 1;
+}
+
+template <class Field>
+int advectField(const Field& f, float h, int steps, int n, float* __restrict x,
+                float* __restrict y, float* __restrict z, float bound,
+                float reseed, unsigned seed) {
+  // step by step across all particles, so each step is one SIMD loop
+  for (int s = 0; s < steps; s++) {
+    for (int i = 0; i < n; i++) {
+      float fx, fy, fz;
+      f(x[i], y[i], z[i], fx, fy, fz);
+      x[i] += h * fx;
+      y[i] += h * fy;
+      z[i] += h * fz;
+    }
+  }
+
+  // branch-free so it vectorizes too; NaN fails the comparisons
+  int reseeded = 0;
+  for (int i = 0; i < n; i++) {
+    bool escaped = !((fabsf(x[i]) < bound) & (fabsf(y[i]) < bound) &
+                     (fabsf(z[i]) < bound));
+    unsigned key = 3 * (seed + i);
+    float rx = reseed * hashUnit(key);
+    float ry = reseed * hashUnit(key + 1);
+    float rz = reseed * hashUnit(key + 2);
+    x[i] = escaped ? rx : x[i];
+    y[i] = escaped ? ry : y[i];
+    z[i] = escaped ? rz : z[i];
+    reseeded += escaped;
+  }
+  return reseeded;
+}
+
+int advect(int mode, const float* params, int steps, int n, float* x,
+           float* y, float* z, float bound, float reseed, unsigned seed) {
+  int reseeded = 0;
+  withField(mode, params, [&](const auto& field) {
+    reseeded = advectField(field, params[1], steps, n, x, y, z, bound,
+                           reseed, seed);
+  });
+  return reseeded;
+}
+
+void ribbon(const float* __restrict points, int n, float width,
+            const float* __restrict widths, float* __restrict vertices) {
+  for (int i = 0; i < n; i++) {
+    // neighbours wrap around the ends, as in Mesh::ribbonize
+    const float* v0 = points + 3 * (i > 0 ? i - 1 : n - 1);
+    const float* v1 = points + 3 * i;
+    const float* v2 = points + 3 * (i < n - 1 ? i + 1 : 0);
+
+    // Mesh::ribbonize's frame: d1 = (v0 - v2) / 2, d2 = 2 (d1 - v1),
+    // binormal b = d2 x d1, normal = d1 x b. With faceBinormal the ribbon
+    // spans the normal, so it faces the binormal.
+    float dx = (v0[0] - v2[0]) * 0.5f;
+    float dy = (v0[1] - v2[1]) * 0.5f;
+    float dz = (v0[2] - v2[2]) * 0.5f;
+    float ex = (dx - v1[0]) * 2, ey = (dy - v1[1]) * 2, ez = (dz - v1[2]) * 2;
+    float bx = ey * dz - ez * dy;
+    float by = ez * dx - ex * dz;
+    float bz = ex * dy - ey * dx;
+    float b = 1 / sqrtf(bx * bx + by * by + bz * bz + 1e-30f);
+    bx *= b;
+    by *= b;
+    bz *= b;
+    float nx = dy * bz - dz * by;
+    float ny = dz * bx - dx * bz;
+    float nz = dx * by - dy * bx;
+    float w = widths ? widths[i] : width;
+    float s = w / sqrtf(nx * nx + ny * ny + nz * nz + 1e-30f);
+
+    float* out = vertices + 6 * i;
+    out[0] = v1[0] - s * nx;
+    out[1] = v1[1] - s * ny;
+    out[2] = v1[2] - s * nz;
+    out[3] = v1[0] + s * nx;
+    out[4] = v1[1] + s * ny;
+    out[5] = v1[2] + s * nz;
+  }
+}
+
+void tube(const float* __restrict points, int n, float radius,
+          const float* __restrict radii, int sides, float* __restrict vertices,
+          float* __restrict normals) {
+  float cosines[kMaxTubeSides], sines[kMaxTubeSides];
+  for (int j = 0; j < sides; j++) {
+    cosines[j] = cosf(6.2831853f * j / sides);
+    sines[j] = sinf(6.2831853f * j / sides);
+  }
+
+  // first normal: x, or y when the curve starts out along x; transport
+  // makes it perpendicular to the tangent
+  float tx = 0, ty = 0, tz = 1;
+  float nx = 1, ny = 0, nz = 0;
+  if (n > 1) {
+    tx = points[3] - points[0], ty = points[4] - points[1], tz = points[5] - points[2];
+    if (fabsf(tx) >= 0.9f * sqrtf(tx * tx + ty * ty + tz * tz)) nx = 0, ny = 1;
+  }
+
+  for (int i = 0; i < n; i++) {
+    // tangent from the neighbours, kept when they coincide
+    const float* v0 = points + 3 * (i > 0 ? i - 1 : 0);
+    const float* v2 = points + 3 * (i < n - 1 ? i + 1 : n - 1);
+    float dx = v2[0] - v0[0], dy = v2[1] - v0[1], dz = v2[2] - v0[2];
+    float length = sqrtf(dx * dx + dy * dy + dz * dz);
+    if (length > 1e-20f) {
+      tx = dx / length, ty = dy / length, tz = dz / length;
+    }
+
+    // parallel transport: the previous normal with its tangent component
+    // removed, which is the rotation-minimizing frame for small steps
+    float d = nx * tx + ny * ty + nz * tz;
+    nx -= d * tx, ny -= d * ty, nz -= d * tz;
+    float s = 1.f / sqrtf(nx * nx + ny * ny + nz * nz + 1e-30f);
+    nx *= s, ny *= s, nz *= s;
+    float bx = ty * nz - tz * ny;
+    float by = tz * nx - tx * nz;
+    float bz = tx * ny - ty * nx;
+
+    const float* center = points + 3 * i;
+    float r = radii ? radii[i] : radius;
+    float* vertex = vertices + 3 * sides * i;
+    float* normal = normals + 3 * sides * i;
+    for (int j = 0; j < sides; j++) {
+      float rx = cosines[j] * nx + sines[j] * bx;
+      float ry = cosines[j] * ny + sines[j] * by;
+      float rz = cosines[j] * nz + sines[j] * bz;
+      normal[3 * j] = rx;
+      normal[3 * j + 1] = ry;
+      normal[3 * j + 2] = rz;
+      vertex[3 * j] = center[0] + r * rx;
+      vertex[3 * j + 1] = center[1] + r * ry;
+      vertex[3 * j + 2] = center[2] + r * rz;
+    }
+  }
+}
+
+void stripNormals(const float* __restrict vertices, int n,
+                  float* __restrict faces, float* __restrict normals) {
+  // face normals, winding alternating along the strip
+  for (int i = 0; i + 2 < n; i++) {
+    const float* a = vertices + 3 * i;
+    const float* b = a + 3;
+    const float* c = a + 6;
+    float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+    float vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+    float flip = (i & 1) ? -1.f : 1.f;
+    faces[3 * i] = flip * (uy * vz - uz * vy);
+    faces[3 * i + 1] = flip * (uz * vx - ux * vz);
+    faces[3 * i + 2] = flip * (ux * vy - uy * vx);
+  }
+
+  // each vertex gathers the (up to) three faces that share it
+  int faceCount = n > 2 ? n - 2 : 0;
+  for (int i = 0; i < n; i++) {
+    int first = i > 1 ? i - 2 : 0;
+    int last = i < faceCount ? i : faceCount - 1;
+    float x = 0, y = 0, z = 0;
+    for (int f = first; f <= last; f++) {
+      x += faces[3 * f];
+      y += faces[3 * f + 1];
+      z += faces[3 * f + 2];
+    }
+    float s = 1.f / sqrtf(x * x + y * y + z * z + 1e-30f);
+    normals[3 * i] = x * s;
+    normals[3 * i + 1] = y * s;
+    normals[3 * i + 2] = z * s;
+  }
+}
+
+void rectify(const float* __restrict in, int n, float* __restrict out) {
+  for (int i = 0; i < n; i++) out[i] = fabsf(in[i]);
+}
+
+void warp(float* envelope, int n, float scale) {
+  for (int i = 0; i < n; i++) {
+    // basic log curve, then ^0.5 (general form is ^(1 / sensitivity))
+    envelope[i] = scale * sqrtf(log10f(envelope[i] * 9.0f + 1.0f));
+  }
+}
+
+}  // namespace
+
+extern const Kernels table;
+const Kernels table{KERNEL_ISA, integrate, integrateCoupled, advect, ribbon,
+                    tube, stripNormals, rectify, warp};
+
+}  // namespace KERNEL_NS
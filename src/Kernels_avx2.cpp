@@ -0,0 +1,3 @@
+#define KERNEL_NS kernels_avx2
+#define KERNEL_ISA "avx2"
+#include "KernelsImpl.hpp"
@@ -0,0 +1,3 @@
+#define KERNEL_NS kernels_avx512
+#define KERNEL_ISA "avx512"
+#include "KernelsImpl.hpp"
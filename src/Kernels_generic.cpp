@@ -0,0 +1,3 @@
+#define KERNEL_NS kernels_generic
+#define KERNEL_ISA "generic"
+#include "KernelsImpl.hpp"
@@ -0,0 +1,337 @@
+// Counters and histograms recorded from any thread without locks or atomic
+// read-modify-writes: each thread owns a cache-line aligned shard that only
+// it writes, with relaxed stores, and readers sum the shards. A thread's
+// first Metrics::local() registers its shard under a mutex, so real-time
+// threads call it once before their hot loop. MetricsSink dumps the
+// totals every few seconds to a file or a UDP socket, as Prometheus text
+// or JSON.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "NodeReport.hpp"
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+class Metrics {
+public:
+  enum Counter {
+    FRAMES,
+    INTEGRATION_STEPS,   // Euler steps of the drawn trajectories
+    MESH_CACHE_HITS,     // frames that reused the mesh as it was
+    INTEGRATION_REUSES,  // mesh rebuilds that reused the integrated points
+    MESH_REBUILDS,
+    AUDIO_CALLBACKS,
+    COUNTERS
+  };
+
+  enum Histogram {
+    FRAME_MS,
+    AUDIO_LOAD,   // callback time over the buffer's duration
+    SYNC_LAG_MS,  // primary stamp to renderer, renderers only
+    HISTOGRAMS
+  };
+
+  static const int kBuckets = 8;  // the last one is +Inf
+
+  static const char* name(Counter counter) {
+    static const char* names[COUNTERS] = {
+        "frames_total",      "integration_steps_total", "mesh_cache_hits_total",
+        "integration_reuses_total", "mesh_rebuilds_total", "audio_callbacks_total"};
+    return names[counter];
+  }
+
+  static const char* name(Histogram histogram) {
+    static const char* names[HISTOGRAMS] = {"frame_ms", "audio_load", "sync_lag_ms"};
+    return names[histogram];
+  }
+
+  // upper bucket bounds, ascending
+  static const double* bounds(Histogram histogram) {
+    static const double bounds[HISTOGRAMS][kBuckets - 1] = {
+        {2, 4, 8, 16.7, 33.3, 50, 100},
+        {0.1, 0.25, 0.5, 0.75, 0.9, 1, 2},
+        {0.5, 1, 2, 5, 10, 20, 50}};
+    return bounds[histogram];
+  }
+
+  // one writer, so plain loads and stores; aligned so threads never share
+  // a cache line
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> counters[COUNTERS];
+    std::atomic<uint64_t> buckets[HISTOGRAMS][kBuckets];
+    std::atomic<double> sums[HISTOGRAMS];
+
+    Shard() {
+      for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+      for (auto& histogram : buckets) {
+        for (auto& bucket : histogram) bucket.store(0, std::memory_order_relaxed);
+      }
+      for (auto& sum : sums) sum.store(0, std::memory_order_relaxed);
+    }
+
+    void add(Counter counter, uint64_t n = 1) {
+      bump(counters[counter], n);
+    }
+
+    void record(Histogram histogram, double value) {
+      const double* bound = bounds(histogram);
+      int bucket = 0;
+      while (bucket < kBuckets - 1 && value > bound[bucket]) bucket++;
+      bump(buckets[histogram][bucket], 1);
+      sums[histogram].store(sums[histogram].load(std::memory_order_relaxed) + value,
+                            std::memory_order_relaxed);
+    }
+
+  private:
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+      value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+  };
+
+  // totals over every shard
+  struct Totals {
+    uint64_t counters[COUNTERS] = {};
+    uint64_t buckets[HISTOGRAMS][kBuckets] = {};
+    double sums[HISTOGRAMS] = {};
+  };
+
+  static Metrics& get() {
+    static Metrics metrics;
+    return metrics;
+  }
+
+  // the calling thread's shard, registered on first use
+  static Shard& local() {
+    static thread_local Shard* shard = get().attach();
+    return *shard;
+  }
+
+  Totals totals() {
+    Totals totals;
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto& shard : mShards) {
+      for (int i = 0; i < COUNTERS; i++) {
+        totals.counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+      }
+      for (int h = 0; h < HISTOGRAMS; h++) {
+        for (int b = 0; b < kBuckets; b++) {
+          totals.buckets[h][b] += shard->buckets[h][b].load(std::memory_order_relaxed);
+        }
+        totals.sums[h] += shard->sums[h].load(std::memory_order_relaxed);
+      }
+    }
+    return totals;
+  }
+
+private:
+  // Shard is over-aligned, which plain new only honours from C++17, so
+  // shards are placed in memory allocated with the alignment
+  struct ShardDelete {
+    void operator()(Shard* shard) const {
+      shard->~Shard();
+#ifdef _WIN32
+      _aligned_free(shard);
+#else
+      std::free(shard);
+#endif
+    }
+  };
+
+  // shards outlive their threads so totals never go backwards
+  Shard* attach() {
+    void* memory = nullptr;
+#ifdef _WIN32
+    memory = _aligned_malloc(sizeof(Shard), alignof(Shard));
+#else
+    if (posix_memalign(&memory, alignof(Shard), sizeof(Shard))) memory = nullptr;
+#endif
+    if (!memory) throw std::bad_alloc();
+    std::unique_ptr<Shard, ShardDelete> shard(new (memory) Shard);
+    std::lock_guard<std::mutex> lock(mLock);
+    mShards.push_back(std::move(shard));
+    return mShards.back().get();
+  }
+
+  std::mutex mLock;  // guards mShards, never taken while recording
+  std::vector<std::unique_ptr<Shard, ShardDelete>> mShards;
+};
+
+// Background thread writing Metrics::totals() every interval seconds, and
+// once more when destroyed. target is a file path, rewritten through a
+// rename so scrapers never read half of it, or udp:<host>:<port> for one
+// datagram per dump.
+class MetricsSink {
+public:
+  MetricsSink(const std::string& target, bool json, double interval,
+              const std::string& node)
+      : mTarget(target), mUdp(target.compare(0, 4, "udp:") == 0), mJson(json),
+        mInterval(interval), mNode(node) {
+    NodeReport::readIO(mStartRead, mStartWritten);
+    if (mUdp) openSocket(target.substr(4));
+    mThread = std::thread([this]() { run(); });
+  }
+
+  ~MetricsSink() {
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mStop = true;
+    }
+    mWake.notify_all();
+    mThread.join();
+#ifndef _WIN32
+    if (mSocket >= 0) close(mSocket);
+#endif
+  }
+
+private:
+  void run() {
+    auto start = std::chrono::steady_clock::now();
+    bool stop = false;
+    while (!stop) {
+      {
+        std::unique_lock<std::mutex> lock(mLock);
+        mWake.wait_for(lock, std::chrono::duration<double>(mInterval),
+                       [this]() { return mStop; });
+        stop = mStop;
+      }
+      double uptime = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start).count();
+      std::string text = mJson ? json(uptime) : prometheus(uptime);
+      if (mUdp) {
+        if (mSocket >= 0) send(text);
+      } else {
+        std::string temporary = mTarget + ".tmp";
+        std::ofstream(temporary) << text;
+        std::rename(temporary.c_str(), mTarget.c_str());
+      }
+    }
+  }
+
+  std::string prometheus(double uptime) {
+    auto totals = Metrics::get().totals();
+    uint64_t read = 0, written = 0;
+    NodeReport::readIO(read, written);
+    std::ostringstream out;
+    out.precision(15);  // counters stay exact well past 2^32
+    std::string label = "{node=\"" + mNode + "\"";
+    auto counter = [&](const std::string& name, double value) {
+      out << "# TYPE allosketch_" << name << " counter\nallosketch_" << name
+          << label << "} " << value << "\n";
+    };
+    counter("uptime_seconds_total", uptime);
+    // everything the process read and wrote through read/write-family
+    // calls, files and sockets alike; allolib's sends can't be told apart
+    counter("process_io_read_bytes_total", double(read - mStartRead));
+    counter("process_io_written_bytes_total", double(written - mStartWritten));
+    for (int i = 0; i < Metrics::COUNTERS; i++) {
+      counter(Metrics::name(Metrics::Counter(i)), double(totals.counters[i]));
+    }
+    for (int h = 0; h < Metrics::HISTOGRAMS; h++) {
+      std::string name = std::string("allosketch_") + Metrics::name(Metrics::Histogram(h));
+      const double* bound = Metrics::bounds(Metrics::Histogram(h));
+      out << "# TYPE " << name << " histogram\n";
+      uint64_t cumulative = 0;
+      for (int b = 0; b < Metrics::kBuckets; b++) {
+        cumulative += totals.buckets[h][b];
+        out << name << "_bucket" << label << ",le=\"";
+        if (b < Metrics::kBuckets - 1) out << bound[b]; else out << "+Inf";
+        out << "\"} " << cumulative << "\n";
+      }
+      out << name << "_sum" << label << "} " << totals.sums[h] << "\n"
+          << name << "_count" << label << "} " << cumulative << "\n";
+    }
+    return out.str();
+  }
+
+  std::string json(double uptime) {
+    auto totals = Metrics::get().totals();
+    uint64_t read = 0, written = 0;
+    NodeReport::readIO(read, written);
+    std::ostringstream out;
+    out.precision(15);
+    out << "{\"node\":\"" << mNode << "\",\"uptime_seconds\":" << uptime
+        << ",\"counters\":{\"process_io_read_bytes_total\":" << read - mStartRead
+        << ",\"process_io_written_bytes_total\":" << written - mStartWritten;
+    for (int i = 0; i < Metrics::COUNTERS; i++) {
+      out << ",\"" << Metrics::name(Metrics::Counter(i)) << "\":" << totals.counters[i];
+    }
+    out << "},\"histograms\":{";
+    for (int h = 0; h < Metrics::HISTOGRAMS; h++) {
+      const double* bound = Metrics::bounds(Metrics::Histogram(h));
+      uint64_t count = 0;
+      out << (h ? "," : "") << "\"" << Metrics::name(Metrics::Histogram(h))
+          << "\":{\"le\":[";
+      for (int b = 0; b < Metrics::kBuckets - 1; b++) out << (b ? "," : "") << bound[b];
+      out << ",null],\"buckets\":[";
+      for (int b = 0; b < Metrics::kBuckets; b++) {
+        count += totals.buckets[h][b];
+        out << (b ? "," : "") << totals.buckets[h][b];
+      }
+      out << "],\"sum\":" << totals.sums[h] << ",\"count\":" << count << "}";
+    }
+    out << "}}\n";
+    return out.str();
+  }
+
+  void openSocket(const std::string& address) {
+#ifndef _WIN32
+    auto colon = address.rfind(':');
+    addrinfo hints{}, *found = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (colon == std::string::npos ||
+        getaddrinfo(address.substr(0, colon).c_str(),
+                    address.substr(colon + 1).c_str(), &hints, &found)) {
+      std::cerr << "Can't resolve metrics address " << address << std::endl;
+      return;
+    }
+    mSocket = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (mSocket >= 0 && connect(mSocket, found->ai_addr, found->ai_addrlen)) {
+      close(mSocket);
+      mSocket = -1;
+    }
+    freeaddrinfo(found);
+#endif
+    if (mSocket < 0) std::cerr << "Can't send metrics to " << address << std::endl;
+  }
+
+  void send(const std::string& text) {
+#ifndef _WIN32
+    ::send(mSocket, text.data(), text.size(), 0);
+#endif
+  }
+
+  std::string mTarget;
+  bool mUdp;
+  bool mJson;
+  double mInterval;
+  std::string mNode;
+  uint64_t mStartRead = 0, mStartWritten = 0;
+  int mSocket = -1;
+  std::thread mThread;
+  std::mutex mLock;
+  std::condition_variable mWake;
+  bool mStop = false;
+};
@@ -0,0 +1,79 @@
+// Geometry morph between two captured trajectories. Both ends are
+// resampled to the same number of points evenly spaced by arc length, so
+// the blend pairs up matching parts of the curves rather than equal step
+// indices, and a morph frame costs one lerp instead of an integration.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class Morph {
+public:
+  enum End { A = 1, B = 2 };
+
+  // storage for trajectories of up to n points, so captures don't allocate
+  void reserve(int n) {
+    for (auto* buffer : {&rawA, &rawB, &a, &b}) buffer->reserve(3 * n);
+    lengths.reserve(n);
+  }
+
+  // copies n xyz points as one end, then resamples both ends to the
+  // larger of their point counts
+  void capture(End end, const float* points, int n) {
+    auto& raw = end == A ? rawA : rawB;
+    raw.assign(points, points + 3 * n);
+    if (ready()) {
+      int m = (int)std::max(rawA.size(), rawB.size()) / 3;
+      resample(rawA, m, a);
+      resample(rawB, m, b);
+    }
+  }
+
+  bool ready() const { return !rawA.empty() && !rawB.empty(); }
+
+  // points per end once both are captured
+  int count() const { return (int)a.size() / 3; }
+
+  // writes count() xyz points, amount 0 being end A and 1 end B
+  void blend(float amount, float* __restrict out) const {
+    const float* __restrict from = a.data();
+    const float* __restrict to = b.data();
+    for (int i = 0, n = 3 * count(); i < n; i++) {
+      out[i] = from[i] + amount * (to[i] - from[i]);
+    }
+  }
+
+private:
+  // m points spaced evenly along the polyline in
+  void resample(const std::vector<float>& in, int m, std::vector<float>& out) {
+    int n = (int)in.size() / 3;
+    lengths.resize(n);
+    lengths[0] = 0;
+    for (int i = 1; i < n; i++) {
+      float dx = in[3 * i] - in[3 * i - 3];
+      float dy = in[3 * i + 1] - in[3 * i - 2];
+      float dz = in[3 * i + 2] - in[3 * i - 1];
+      lengths[i] = lengths[i - 1] + std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    out.resize(3 * m);
+    int segment = 0;
+    for (int j = 0; j < m; j++) {
+      float target = m > 1 ? lengths[n - 1] * j / (m - 1) : 0;
+      while (segment < n - 2 && lengths[segment + 1] < target) segment++;
+      int next = std::min(segment + 1, n - 1);
+      float span = lengths[next] - lengths[segment];
+      float t = span > 0 ? (target - lengths[segment]) / span : 0;
+      for (int k = 0; k < 3; k++) {
+        float from = in[3 * segment + k], to = in[3 * next + k];
+        out[3 * j + k] = from + t * (to - from);
+      }
+    }
+  }
+
+  std::vector<float> rawA, rawB;  // captured as integrated
+  std::vector<float> a, b;        // resampled to count() points
+  std::vector<float> lengths;     // arc length up to each raw point
+};
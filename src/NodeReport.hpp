@@ -0,0 +1,81 @@
+// Per-node measurements for the local cluster harness (cluster.sh): frame
+// rate, primary -> renderer sync latency, parameter-apply lag and bytes of
+// I/O, written as key=value lines on exit with --report.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+class NodeReport {
+public:
+  // running count, mean and max of a series of milliseconds
+  struct Series {
+    uint64_t count = 0;
+    double sum = 0, max = 0;
+
+    void add(double ms) {
+      count++;
+      sum += ms;
+      max = std::max(max, ms);
+    }
+    double mean() const { return count ? sum / count : 0; }
+  };
+
+  // steady_clock is CLOCK_MONOTONIC on Linux, comparable between processes
+  // on one machine, so primary timestamps can be measured on a renderer
+  static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  NodeReport() { readIO(mStartRead, mStartWritten); }
+
+  void frame(double dt) {
+    mFrames++;
+    mFrameMs.add(dt * 1000);
+  }
+
+  Series& syncLatency() { return mSyncLatency; }
+  Series& applyLag() { return mApplyLag; }
+
+  bool write(const std::string& path, const std::string& node) {
+    std::ofstream file(path);
+    if (!file) return false;
+    uint64_t read = 0, written = 0;
+    readIO(read, written);
+    double seconds = mFrameMs.sum / 1000;
+
+    file << "node=" << node << "\n"
+         << "frames=" << mFrames << "\n"
+         << "fps=" << (seconds > 0 ? mFrames / seconds : 0) << "\n"
+         << "frame_ms_max=" << mFrameMs.max << "\n"
+         << "sync_latency_ms_mean=" << mSyncLatency.mean() << "\n"
+         << "sync_latency_ms_max=" << mSyncLatency.max << "\n"
+         << "apply_lag_ms_mean=" << mApplyLag.mean() << "\n"
+         << "apply_lag_ms_max=" << mApplyLag.max << "\n"
+         << "io_read_bytes=" << read - mStartRead << "\n"
+         << "io_written_bytes=" << written - mStartWritten << "\n";
+    return true;
+  }
+
+  // bytes through read/write-family calls, sockets included (Linux only)
+  static void readIO(uint64_t& read, uint64_t& written) {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value;
+    while (io >> key >> value) {
+      if (key == "rchar:") read = value;
+      if (key == "wchar:") written = value;
+    }
+  }
+
+private:
+  uint64_t mFrames = 0;
+  Series mFrameMs, mSyncLatency, mApplyLag;
+  uint64_t mStartRead = 0, mStartWritten = 0;
+};
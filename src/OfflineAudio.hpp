@@ -0,0 +1,136 @@
+// Audio backends that need no sound card: input is silence ("null") or a WAV
+// file, output is discarded or written to a WAV file, and blocks are clocked
+// by a high-resolution timer (real time) or run as fast as possible. The
+// callback gets an AudioIOData shaped like the configured device.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "al/io/al_AudioIO.hpp"
+#include "Wav.hpp"
+using namespace al;
+
+class OfflineAudio {
+public:
+  using Callback = std::function<void(AudioIOData&)>;
+
+  ~OfflineAudio() { stop(); }
+
+  // same arguments as App::configureAudio
+  void configure(double sampleRate, int blockSize, int outputs, int inputs) {
+    mIO.framesPerSecond(sampleRate);
+    mIO.framesPerBuffer(blockSize);
+    mIO.channelsOut(outputs);
+    mIO.channelsIn(inputs);
+  }
+
+  // empty path = silent input
+  bool input(const std::string& wavPath) {
+    if (wavPath.empty()) return true;
+    if (!mInput.open(wavPath)) return false;
+    if (mInput.sampleRate() != (int)mIO.framesPerSecond()) {
+      std::cerr << wavPath << " is " << mInput.sampleRate()
+                << " Hz, played unresampled at " << mIO.framesPerSecond()
+                << " Hz" << std::endl;
+    }
+    return true;
+  }
+
+  // empty path = discard output
+  bool output(const std::string& wavPath) {
+    if (wavPath.empty()) return true;
+    return mOutput.open(wavPath, mIO.channelsOut(), (int)mIO.framesPerSecond());
+  }
+
+  void start(Callback callback, bool realtime) {
+    mRunning = true;
+    mThread = std::thread([this, callback, realtime]() { run(callback, realtime); });
+  }
+
+  // callback time over block period since the last call, 1 = no headroom
+  double takeLoad() {
+    double ns = (double)mWindowNs.exchange(0);
+    double blocks = (double)mWindowBlocks.exchange(0);
+    double blockNs = 1e9 * mIO.framesPerBuffer() / mIO.framesPerSecond();
+    return blocks ? ns / blocks / blockNs : 0;
+  }
+
+  void stop() {
+    if (!mThread.joinable()) return;
+    mRunning = false;
+    mThread.join();
+    mOutput.close();
+
+    double blockUs = 1e6 * mIO.framesPerBuffer() / mIO.framesPerSecond();
+    double callbackUs = mBlocks ? mCallbackUs / mBlocks : 0;
+    std::cout << "[audio] " << mBlocks << " blocks, " << callbackUs
+              << " us per callback (" << 100 * callbackUs / blockUs
+              << "% load), " << mLate << " late" << std::endl;
+  }
+
+private:
+  void run(const Callback& callback, bool realtime) {
+    using Clock = std::chrono::steady_clock;
+    const int frames = mIO.framesPerBuffer();
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(frames / mIO.framesPerSecond()));
+    std::vector<const float*> outputs(mIO.channelsOut());
+    uint64_t position = 0;
+    auto deadline = Clock::now();
+
+    while (mRunning) {
+      for (int c = 0; c < mIO.channelsIn(); c++) {
+        // the input buffers are ours to fill
+        float* in = const_cast<float*>(mIO.inBuffer(c));
+        if (mInput.frames()) {
+          mInput.read(c, position, frames, in);
+        } else {
+          std::fill(in, in + frames, 0.f);
+        }
+      }
+      position += frames;
+
+      auto start = Clock::now();
+      callback(mIO);
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - start).count();
+      mCallbackUs += ns / 1000.0;
+      mBlocks++;
+      mWindowNs += ns;
+      mWindowBlocks++;
+
+      if (mOutput.isOpen()) {
+        for (int c = 0; c < mIO.channelsOut(); c++) {
+          outputs[c] = mIO.outBuffer(c);
+        }
+        mOutput.write(outputs.data(), frames);
+      }
+
+      if (realtime) {
+        deadline += period;
+        auto now = Clock::now();
+        if (now > deadline + period) {
+          mLate++;  // more than a block behind: drop the backlog
+          deadline = now;
+        }
+        std::this_thread::sleep_until(deadline);
+      }
+    }
+  }
+
+  AudioIOData mIO;
+  WavReader mInput;
+  WavWriter mOutput;
+  std::thread mThread;
+  std::atomic<bool> mRunning{false};
+  uint64_t mBlocks = 0, mLate = 0;
+  double mCallbackUs = 0;
+  std::atomic<uint64_t> mWindowNs{0}, mWindowBlocks{0};  // for takeLoad()
+};
@@ -0,0 +1,112 @@
+// Command line options shared by every node
+
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+
+struct Options {
+  // primary audio backend: "device", "null" (silence) or "file" (audioIn)
+  std::string audio{"device"};
+  std::string audioIn;   // WAV read by the file backend
+  std::string audioOut;  // WAV the offline backends write, empty discards
+  bool audioRealtime = true;  // false runs the offline backends flat out
+
+  // unattended runs, see cluster.sh
+  std::string show;        // script the primary plays back
+  std::string recordShow;  // script the primary's key presses are saved to
+  std::string report;      // NodeReport written here on exit
+  double duration = 0;     // quit after this many seconds, 0 runs forever
+
+  // identifies this node in the primary's renderer stats, defaults to the
+  // host name
+  std::string name;
+
+  // per thread role (audio, workers, render, network), see ThreadTuning.hpp
+  std::map<std::string, std::string> pin;  // role -> "cpu,cpu"
+  std::map<std::string, int> priority;     // role -> SCHED_FIFO priority, 1-99
+  bool lockMemory = false;    // mlockall once buffers are allocated
+  bool threadReport = false;  // print context switches and faults on exit
+
+  // periodic metrics dump, see Metrics.hpp
+  std::string metrics;  // file path or udp:<host>:<port>, empty disables
+  bool metricsJson = false;  // JSON instead of Prometheus text
+  double metricsInterval = 5;  // seconds between dumps
+
+  // primary geometry export, see Exporter.hpp
+  std::string exportFormat{"ply"};  // "ply", "obj" or "gltf"
+  std::string exportDir{"."};
+  bool exportPoints = false;    // raw trajectories instead of the mesh
+  bool exportOnPreset = false;  // export after every preset recall
+
+  static Options parse(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+      if (!std::strcmp(argv[i], "--audio=null")) {
+        options.audio = "null";
+      } else if (!std::strncmp(argv[i], "--audio=file:", 13)) {
+        options.audio = "file";
+        options.audioIn = argv[i] + 13;
+      } else if (!std::strncmp(argv[i], "--audio-out=", 12)) {
+        options.audioOut = argv[i] + 12;
+      } else if (!std::strcmp(argv[i], "--audio-clock=fast")) {
+        options.audioRealtime = false;
+      } else if (!std::strncmp(argv[i], "--show=", 7)) {
+        options.show = argv[i] + 7;
+      } else if (!std::strncmp(argv[i], "--record-show=", 14)) {
+        options.recordShow = argv[i] + 14;
+      } else if (!std::strncmp(argv[i], "--report=", 9)) {
+        options.report = argv[i] + 9;
+      } else if (!std::strncmp(argv[i], "--duration=", 11)) {
+        options.duration = std::atof(argv[i] + 11);
+      } else if (!std::strncmp(argv[i], "--pin-", 6) && std::strchr(argv[i], '=')) {
+        char* value = std::strchr(argv[i], '=');
+        options.pin[std::string(argv[i] + 6, value)] = value + 1;
+      } else if (!std::strncmp(argv[i], "--priority-", 11) && std::strchr(argv[i], '=')) {
+        char* value = std::strchr(argv[i], '=');
+        char* end = nullptr;
+        long priority = std::strtol(value + 1, &end, 10);
+        if (!value[1] || *end || priority < 1 || priority > 99) {
+          std::cerr << "Ignoring " << argv[i] << ": SCHED_FIFO priorities are 1-99"
+                    << std::endl;
+        } else {
+          options.priority[std::string(argv[i] + 11, value)] = (int)priority;
+        }
+      } else if (!std::strcmp(argv[i], "--mlock")) {
+        options.lockMemory = true;
+      } else if (!std::strcmp(argv[i], "--thread-report")) {
+        options.threadReport = true;
+      } else if (!std::strncmp(argv[i], "--name=", 7)) {
+        options.name = argv[i] + 7;
+      } else if (!std::strncmp(argv[i], "--metrics=", 10)) {
+        options.metrics = argv[i] + 10;
+      } else if (!std::strcmp(argv[i], "--metrics-format=json")) {
+        options.metricsJson = true;
+      } else if (!std::strcmp(argv[i], "--metrics-format=prometheus")) {
+        options.metricsJson = false;
+      } else if (!std::strncmp(argv[i], "--metrics-interval=", 19)) {
+        options.metricsInterval = std::atof(argv[i] + 19);
+      } else if (!std::strncmp(argv[i], "--export=", 9)) {
+        std::string format = argv[i] + 9;
+        if (format == "ply" || format == "obj" || format == "gltf") {
+          options.exportFormat = format;
+        } else {
+          std::cerr << "Unknown export format " << format << " (ply, obj or gltf), keeping "
+                    << options.exportFormat << std::endl;
+        }
+      } else if (!std::strncmp(argv[i], "--export-dir=", 13)) {
+        options.exportDir = argv[i] + 13;
+      } else if (!std::strcmp(argv[i], "--export-points")) {
+        options.exportPoints = true;
+      } else if (!std::strcmp(argv[i], "--export-on-preset")) {
+        options.exportOnPreset = true;
+      } else {
+        std::cerr << "Ignoring unknown option " << argv[i] << std::endl;
+      }
+    }
+    return options;
+  }
+};
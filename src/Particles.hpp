@@ -0,0 +1,80 @@
+// Particle cloud advected through an attractor's vector field: positions
+// are kept as separate x, y and z arrays for the advect kernel, stepped a
+// chunk at a time across the shared WorkerPool and interleaved into a
+// POINTS mesh by the same chunk jobs.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "al/graphics/al_VAOMesh.hpp"
+#include "Kernels.hpp"
+#include "WorkerPool.hpp"
+using namespace al;
+
+class Particles {
+public:
+  static const int kChunk = 16384;  // 192 KB of positions, stays in L2
+
+  // allocates count particles spread uniformly over [-reseed, reseed]^3
+  void resize(int count, float reseed) {
+    range = reseed;
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    cloud.reset();
+    cloud.primitive(Mesh::POINTS);
+    cloud.vertices().resize(count);
+    // a bound of zero reseeds everything
+    forEachChunk([&](int start, int n) {
+      kernels().advect(0, noParams, 0, n, &x[start], &y[start], &z[start],
+                       0, range, start);
+      interleave(start, n);
+    });
+  }
+
+  int count() const { return (int)x.size(); }
+
+  // steps every particle of attractor `mode` with the Attractor's p[]
+  // values, reseeding the ones that leave [-bound, bound]^3; returns how
+  // many were reseeded. The mesh vertices are updated, not uploaded.
+  int advance(int mode, const float* params, int steps, float bound) {
+    std::atomic<int> reseeded{0};
+    unsigned seed = ++frame * (unsigned)count();
+    forEachChunk([&](int start, int n) {
+      reseeded += kernels().advect(mode, params, steps, n, &x[start],
+                                   &y[start], &z[start], bound, range,
+                                   seed + start);
+      interleave(start, n);
+    });
+    return reseeded;
+  }
+
+  VAOMesh& mesh() { return cloud; }
+
+private:
+  template <class Job>
+  void forEachChunk(Job job) {
+    int chunks = (count() + kChunk - 1) / kChunk;
+    WorkerPool::shared().run(chunks, [&](int chunk) {
+      int start = chunk * kChunk, rest = count() - start;
+      job(start, rest < kChunk ? rest : kChunk);
+    });
+  }
+
+  void interleave(int start, int n) {
+    float* out = &cloud.vertices()[start][0];
+    for (int i = 0; i < n; i++, out += 3) {
+      out[0] = x[start + i];
+      out[1] = y[start + i];
+      out[2] = z[start + i];
+    }
+  }
+
+  std::vector<float> x, y, z;
+  VAOMesh cloud;
+  float range = 0;
+  unsigned frame = 0;
+  const float noParams[15] = {};
+};
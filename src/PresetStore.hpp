@@ -0,0 +1,350 @@
+// Presets in allolib's text format (presets/<name>.preset plus
+// default.presetMap), kept parsed in memory so recalling one never touches
+// the disk. Stores are written by a background thread, via a temporary file
+// and a rename, and presets/ is watched (inotify on Linux, polling
+// elsewhere) so files edited by hand are reloaded one by one while the show
+// runs. A reload of the current preset is applied by the next
+// applyReloaded() on the main thread, never by the watcher.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include "al/ui/al_Parameter.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+class PresetStore {
+public:
+  explicit PresetStore(const std::string& directory) : mDirectory(directory) {}
+
+  ~PresetStore() {
+    {
+      std::lock_guard<std::mutex> lock(mWriteLock);
+      mStop = true;
+    }
+    mWake.notify_all();
+    if (mWriter.joinable()) mWriter.join();
+    if (mWatcher.joinable()) mWatcher.join();
+  }
+
+  // parameters presets are applied to, matched by full OSC address
+  PresetStore& operator<<(al::ParameterMeta& param) {
+    if (!dynamic_cast<al::Trigger*>(&param)) {
+      mParams[param.getFullAddress()] = &param;
+    }
+    return *this;
+  }
+
+  // loads every mapped preset, then starts the writer and the watcher
+  void start() {
+    loadMap();
+    std::map<int, std::string> names;
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      names = mNames;
+    }
+    for (auto& name : names) load(name.second);
+    mWriter = std::thread([this]() { write(); });
+    mWatcher = std::thread([this]() { watch(); });
+  }
+
+  // applies preset index from memory, returning false if there is none
+  bool recall(int index) {
+    std::shared_ptr<const Preset> preset;
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      auto name = mNames.find(index);
+      if (name == mNames.end()) return false;
+      auto found = mPresets.find(name->second);
+      if (found == mPresets.end()) return false;
+      preset = found->second;
+    }
+    for (auto& value : *preset) {
+      value.first->fromFloat(value.second);
+    }
+    mCurrent = index;
+    return true;
+  }
+
+  // saves the current values as preset index; recall sees them at once and
+  // the files are written in the background
+  void store(int index) {
+    auto preset = std::make_shared<Preset>();
+    for (auto& param : mParams) {
+      preset->emplace_back(param.second, param.second->toFloat());
+    }
+
+    std::string name, map;
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      auto found = mNames.find(index);
+      if (found == mNames.end()) {
+        found = mNames.emplace(index, std::to_string(index)).first;
+        map = mapText();
+      }
+      name = found->second;
+      mPresets[name] = preset;
+    }
+
+    std::string text = "::" + name + "\n";
+    for (auto& param : mParams) {
+      // %.9g round-trips every float; h spans 0 to 0.018, where six
+      // decimals would visibly change the trajectory
+      char value[32];
+      std::snprintf(value, sizeof(value), "%.9g", param.second->toFloat());
+      text += param.first + " f " + value + " \n";
+    }
+    text += "::\n";
+    {
+      std::lock_guard<std::mutex> lock(mWriteLock);
+      mWrites.emplace_back(path(name + ".preset"), text);
+      if (!map.empty()) mWrites.emplace_back(path("default.presetMap"), map);
+    }
+    mWake.notify_all();
+    mCurrent = index;
+  }
+
+  // last preset recalled or stored, -1 before the first
+  int current() const { return mCurrent; }
+
+  // re-applies the current preset if its file or the map changed on disk
+  // since the last call; from the thread that owns the parameters
+  void applyReloaded() {
+    if (mReloaded.exchange(false) && mCurrent >= 0) recall(mCurrent);
+  }
+
+private:
+  typedef std::vector<std::pair<al::ParameterMeta*, float>> Preset;
+
+  std::string path(const std::string& file) const {
+    return mDirectory + "/" + file;
+  }
+
+  static bool endsWith(const std::string& text, const std::string& end) {
+    return text.size() >= end.size() &&
+           text.compare(text.size() - end.size(), end.size(), end) == 0;
+  }
+
+  // parses one preset file outside the lock, then swaps it in
+  void load(const std::string& name) {
+    std::ifstream file(path(name + ".preset"));
+    if (!file) {
+      std::lock_guard<std::mutex> lock(mLock);
+      mPresets.erase(name);
+      return;
+    }
+    auto preset = std::make_shared<Preset>();
+    std::string line;
+    while (std::getline(file, line)) {
+      // "/p/h f 0.003000"; "::" lines open and close the preset
+      std::istringstream fields(line);
+      std::string address, type;
+      float value;
+      if (!(fields >> address >> type >> value)) continue;
+      auto param = mParams.find(address);
+      if (param != mParams.end()) preset->emplace_back(param->second, value);
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    mPresets[name] = preset;
+  }
+
+  // "index:name" lines, closed by "::"
+  void loadMap() {
+    std::ifstream file(path("default.presetMap"));
+    std::map<int, std::string> names;
+    std::string line;
+    while (std::getline(file, line)) {
+      auto colon = line.find(':');
+      if (colon == 0 || colon == std::string::npos) continue;
+      names[std::atoi(line.c_str())] = line.substr(colon + 1);
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    mNames = names;
+  }
+
+  // callers hold mLock
+  std::string mapText() const {
+    std::string text;
+    for (auto& name : mNames) {
+      text += std::to_string(name.first) + ":" + name.second + "\n";
+    }
+    return text + "::\n";
+  }
+
+  // identity of a file as written: a hand edit changes at least one
+  struct Stamp {
+    long long inode = -1, size = -1, mtime = -1, mtimeNs = 0;
+    bool operator==(const Stamp& other) const {
+      return inode == other.inode && size == other.size && mtime == other.mtime &&
+             mtimeNs == other.mtimeNs;
+    }
+  };
+
+  static Stamp stamp(const std::string& file) {
+    Stamp stamp;
+    struct stat info;
+    if (stat(file.c_str(), &info)) return stamp;
+    stamp.inode = info.st_ino;
+    stamp.size = info.st_size;
+    stamp.mtime = info.st_mtime;
+#if defined(__linux__)
+    stamp.mtimeNs = info.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    stamp.mtimeNs = info.st_mtimespec.tv_nsec;
+#endif
+    return stamp;
+  }
+
+  // a file in the directory changed on disk; runs on the watcher, so the
+  // current preset is only flagged for applyReloaded(). Files as write()
+  // left them are skipped: memory already has their values, unrounded.
+  void changed(const std::string& file) {
+    {
+      std::lock_guard<std::mutex> lock(mWriteLock);
+      auto written = mWritten.find(file);
+      if (written != mWritten.end() && written->second == stamp(path(file))) return;
+    }
+    if (file == "default.presetMap") {
+      loadMap();
+      mReloaded = true;  // the current index may name another preset now
+    } else if (endsWith(file, ".preset")) {
+      std::string name = file.substr(0, file.size() - 7);
+      load(name);
+      std::lock_guard<std::mutex> lock(mLock);
+      auto current = mNames.find(mCurrent);
+      if (current != mNames.end() && current->second == name) mReloaded = true;
+    } else {
+      return;  // our own temporary files among others
+    }
+    std::cout << "Reloaded " << path(file) << std::endl;
+  }
+
+  void write() {
+    while (true) {
+      std::pair<std::string, std::string> next;
+      {
+        std::unique_lock<std::mutex> lock(mWriteLock);
+        mWake.wait(lock, [this]() { return mStop || !mWrites.empty(); });
+        if (mWrites.empty()) return;
+        next = std::move(mWrites.front());
+        mWrites.erase(mWrites.begin());
+      }
+      // the watcher and other readers only ever see complete files
+      std::string temporary = next.first + ".tmp";
+      std::ofstream file(temporary);
+      file << next.second;
+      file.close();
+      if (!file) {
+        // a partial file must never replace a good one
+        std::cerr << "Couldn't write " << temporary << std::endl;
+        std::remove(temporary.c_str());
+        continue;
+      }
+      // recorded before the rename, which keeps inode and mtime, so the
+      // watcher can't see the file before it is known as ours
+      std::string name = next.first.substr(mDirectory.size() + 1);
+      {
+        std::lock_guard<std::mutex> lock(mWriteLock);
+        mWritten[name] = stamp(temporary);
+      }
+#ifdef _WIN32
+      std::remove(next.first.c_str());
+#endif
+      if (std::rename(temporary.c_str(), next.first.c_str())) {
+        std::cerr << "Couldn't write " << next.first << std::endl;
+        std::lock_guard<std::mutex> lock(mWriteLock);
+        mWritten.erase(name);
+      }
+    }
+  }
+
+  bool stopping() {
+    std::lock_guard<std::mutex> lock(mWriteLock);
+    return mStop;
+  }
+
+  void watch() {
+#ifdef __linux__
+    int events = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (events >= 0 &&
+        inotify_add_watch(events, mDirectory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) >= 0) {
+      alignas(inotify_event) char buffer[4096];
+      while (!stopping()) {
+        pollfd ready{events, POLLIN, 0};
+        if (poll(&ready, 1, kStopCheckMs) <= 0) continue;
+        ssize_t length = read(events, buffer, sizeof(buffer));
+        for (char* at = buffer; at < buffer + length;) {
+          auto* event = (inotify_event*)at;
+          if (event->len) changed(event->name);
+          at += sizeof(inotify_event) + event->len;
+        }
+      }
+      close(events);
+      return;
+    }
+    if (events >= 0) close(events);
+    std::cerr << "Can't watch " << mDirectory << ", polling it instead" << std::endl;
+#endif
+    // stats the map and every mapped preset; renamed-in files change mtime
+    // or size
+    std::map<std::string, std::pair<long long, long long>> seen;
+    auto scan = [&](bool report) {
+      std::vector<std::string> files{"default.presetMap"};
+      {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto& name : mNames) files.push_back(name.second + ".preset");
+      }
+      for (auto& file : files) {
+        struct stat info;
+        std::pair<long long, long long> state{-1, -1};
+        if (!stat(path(file).c_str(), &info)) state = {info.st_mtime, info.st_size};
+        auto& last = seen[file];
+        if (last != state && report) changed(file);
+        last = state;
+      }
+    };
+    scan(false);
+    while (!stopping()) {
+      for (int waited = 0; waited < kPollMs && !stopping(); waited += kStopCheckMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kStopCheckMs));
+      }
+      scan(true);
+    }
+  }
+
+  enum { kPollMs = 1000, kStopCheckMs = 200 };
+
+  std::string mDirectory;
+  std::map<std::string, al::ParameterMeta*> mParams;  // by address, set up front
+  std::mutex mLock;  // guards mNames and mPresets
+  std::map<int, std::string> mNames;
+  std::map<std::string, std::shared_ptr<const Preset>> mPresets;  // by name
+  std::atomic<int> mCurrent{-1};
+  std::atomic<bool> mReloaded{false};  // set by the watcher
+  std::thread mWriter, mWatcher;
+  std::mutex mWriteLock;  // guards mWrites, mWritten and mStop
+  std::condition_variable mWake;
+  std::vector<std::pair<std::string, std::string>> mWrites;  // path, text
+  std::map<std::string, Stamp> mWritten;  // file name -> as write() left it
+  bool mStop = false;
+};
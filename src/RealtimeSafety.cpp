@@ -0,0 +1,195 @@
+// Interposers behind RealtimeSafety.hpp, only built with ALLOSKETCH_RT_CHECK.
+// On Linux the malloc family, pthread_mutex_lock and the common blocking
+// syscall wrappers are replaced by checking versions that forward to glibc;
+// elsewhere only operator new/delete are checked.
+
+#include "RealtimeSafety.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+namespace {
+
+// plain thread_local ints: no dynamic TLS initialization, which could itself
+// allocate from inside malloc
+thread_local int tlRealtimeDepth = 0;
+thread_local bool tlReporting = false;
+std::atomic<size_t> gViolations{0};
+const size_t kMaxReports = 20;  // then only count
+
+bool checking() { return tlRealtimeDepth > 0 && !tlReporting; }
+
+void writeStderr(const char* text, int length) {
+#ifdef __linux__
+  syscall(SYS_write, 2, text, length);
+#else
+  std::fwrite(text, 1, length, stderr);
+#endif
+}
+
+void report(const char* what) {
+  tlReporting = true;  // the report itself may allocate or write
+  size_t count = ++gViolations;
+  if (count <= kMaxReports) {
+    char line[160];
+    int length = std::snprintf(line, sizeof(line),
+                               "[rt-check] %s on a real-time thread\n", what);
+    writeStderr(line, length);
+#if defined(__linux__) || defined(__APPLE__)
+    void* frames[32];
+    int depth = backtrace(frames, 32);
+    backtrace_symbols_fd(frames + 1, depth - 1, 2);
+#endif
+    if (count == kMaxReports) {
+      const char* quiet = "[rt-check] further violations are only counted\n";
+      writeStderr(quiet, (int)std::strlen(quiet));
+    }
+  }
+  tlReporting = false;
+}
+
+}  // namespace
+
+RealtimeScope::RealtimeScope() { tlRealtimeDepth++; }
+RealtimeScope::~RealtimeScope() { tlRealtimeDepth--; }
+
+size_t realtimeViolations() { return gViolations.load(); }
+
+#ifdef __linux__
+
+extern "C" {
+
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void __libc_free(void*);
+void* __libc_memalign(size_t, size_t);
+
+void* malloc(size_t size) {
+  if (checking()) report("malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  if (checking()) report("calloc");
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size) {
+  if (checking()) report("realloc");
+  return __libc_realloc(memory, size);
+}
+
+// glibc has no __libc_ entry points for these two, so they go through
+// dlsym like pthread_mutex_lock
+int posix_memalign(void** memory, size_t alignment, size_t size) {
+  using Allocate = int (*)(void**, size_t, size_t);
+  static Allocate next = (Allocate)dlsym(RTLD_NEXT, "posix_memalign");
+  if (checking()) report("posix_memalign");
+  return next(memory, alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  using Allocate = void* (*)(size_t, size_t);
+  static Allocate next = (Allocate)dlsym(RTLD_NEXT, "aligned_alloc");
+  if (checking()) report("aligned_alloc");
+  return next(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  if (checking()) report("memalign");
+  return __libc_memalign(alignment, size);
+}
+
+void free(void* memory) {
+  if (memory && checking()) report("free");
+  __libc_free(memory);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+  using Lock = int (*)(pthread_mutex_t*);
+  static Lock next = (Lock)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+  if (checking()) report("pthread_mutex_lock");
+  return next(mutex);
+}
+
+ssize_t read(int fd, void* buffer, size_t size) {
+  if (checking()) report("read");
+  return syscall(SYS_read, fd, buffer, size);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size) {
+  if (checking()) report("write");
+  return syscall(SYS_write, fd, buffer, size);
+}
+
+int open(const char* path, int flags, ...) {
+  if (checking()) report("open");
+  mode_t mode = 0;
+  if (flags & (O_CREAT | O_TMPFILE)) {
+    va_list args;
+    va_start(args, flags);
+    mode = va_arg(args, mode_t);
+    va_end(args);
+  }
+  return syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+}
+
+int close(int fd) {
+  if (checking()) report("close");
+  return syscall(SYS_close, fd);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+  if (checking()) report("nanosleep");
+  return syscall(SYS_nanosleep, duration, remaining);
+}
+
+ssize_t send(int fd, const void* buffer, size_t size, int flags) {
+  if (checking()) report("send");
+  return syscall(SYS_sendto, fd, buffer, size, flags, nullptr, 0);
+}
+
+ssize_t sendto(int fd, const void* buffer, size_t size, int flags,
+               const struct sockaddr* address, socklen_t addressLength) {
+  if (checking()) report("sendto");
+  return syscall(SYS_sendto, fd, buffer, size, flags, address, addressLength);
+}
+
+}  // extern "C"
+
+#else
+
+void* operator new(size_t size) {
+  if (checking()) report("operator new");
+  if (void* memory = std::malloc(size ? size : 1)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  if (memory && checking()) report("operator delete");
+  std::free(memory);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* memory) noexcept { operator delete(memory); }
+
+#endif
@@ -0,0 +1,36 @@
+// Debug check for the audio thread. With ALLOSKETCH_RT_CHECK defined (CMake
+// option of the same name), heap allocation, mutex locks and blocking
+// syscalls made while a RealtimeScope is alive on the calling thread are
+// logged with a stack trace and counted. Without it everything here
+// compiles away.
+
+#pragma once
+
+#include <cstddef>
+
+#ifdef ALLOSKETCH_RT_CHECK
+
+// marks the calling thread as real-time for the lifetime of the scope
+class RealtimeScope {
+public:
+  RealtimeScope();
+  ~RealtimeScope();
+  RealtimeScope(const RealtimeScope&) = delete;
+  RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
+
+// violations seen so far, on any thread
+size_t realtimeViolations();
+
+#else
+
+// user-provided so `RealtimeScope realtime;` isn't an unused variable
+class RealtimeScope {
+public:
+  RealtimeScope() {}
+  ~RealtimeScope() {}
+};
+
+inline size_t realtimeViolations() { return 0; }
+
+#endif
@@ -0,0 +1,134 @@
+// Renderer performance as seen from the primary. Each renderer sums its
+// frames into a RendererStats and, every half second, sends the summary
+// as one line of text on an OSC address of its own, /<node>/rendererStats:
+// "<node> <frames> <mean ms> <max ms> <dropped> <vertices> <cache hits>".
+// The primary's RendererBoard keeps per-node totals and names the slowest
+// node for its GUI. Times on the board are the primary's steady clock,
+// read by whichever thread calls in.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+class RendererStats {
+public:
+  // frames longer than this count as dropped, 1.5 periods at 60 Hz
+  static constexpr double kDroppedMs = 25;
+
+  // cacheHit: the frame drew the mesh without rebuilding it
+  void frame(double dt, int vertices, bool cacheHit) {
+    double ms = dt * 1000;
+    mFrames++;
+    mSumMs += ms;
+    mMaxMs = std::max(mMaxMs, ms);
+    if (ms > kDroppedMs) mDropped++;
+    if (cacheHit) mCacheHits++;
+    mVertices = vertices;
+  }
+
+  // the message for the frames since the last call
+  std::string take(const std::string& node) {
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(2) << node << " " << mFrames
+            << " " << (mFrames ? mSumMs / mFrames : 0) << " " << mMaxMs << " "
+            << mDropped << " " << mVertices << " " << mCacheHits;
+    mFrames = mDropped = mCacheHits = 0;
+    mSumMs = mMaxMs = 0;
+    return message.str();
+  }
+
+private:
+  uint64_t mFrames = 0, mDropped = 0, mCacheHits = 0;
+  double mSumMs = 0, mMaxMs = 0;
+  int mVertices = 0;
+};
+
+class RendererBoard {
+public:
+  // a node not heard from for this long is reported as silent
+  static constexpr double kSilentSeconds = 2;
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Node {
+    Clock::time_point lastSeen;  // arrival of the last message
+    double meanMs = 0, maxMs = 0;  // last interval
+    double worstMs = 0;            // whole run
+    uint64_t frames = 0, dropped = 0, cacheHits = 0;  // whole run
+    int vertices = 0;
+  };
+
+  // called from the parameter server's thread
+  void receive(const std::string& message) {
+    auto now = Clock::now();
+    std::istringstream fields(message);
+    std::string name;
+    uint64_t frames, dropped, cacheHits;
+    double meanMs, maxMs;
+    int vertices;
+    if (!(fields >> name >> frames >> meanMs >> maxMs >> dropped >> vertices >> cacheHits)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    Node& node = mNodes[name];
+    node.lastSeen = now;
+    node.meanMs = meanMs;
+    node.maxMs = maxMs;
+    node.worstMs = std::max(node.worstMs, maxMs);
+    node.frames += frames;
+    node.dropped += dropped;
+    node.cacheHits += cacheHits;
+    node.vertices = vertices;
+  }
+
+  // one line for the GUI: node count, the slowest node's last interval and
+  // any silent nodes
+  std::string summary() {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mLock);
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << mNodes.size() << " renderers";
+    const std::pair<const std::string, Node>* slowest = nullptr;
+    std::string silent;
+    for (auto& node : mNodes) {
+      if (std::chrono::duration<double>(now - node.second.lastSeen).count() >
+          kSilentSeconds) {
+        silent += " " + node.first;
+      } else if (!slowest || node.second.meanMs > slowest->second.meanMs) {
+        slowest = &node;
+      }
+    }
+    if (slowest) {
+      text << ", slowest " << slowest->first << " " << slowest->second.meanMs
+           << " ms (max " << slowest->second.maxMs << ", "
+           << slowest->second.dropped << " dropped)";
+    }
+    if (!silent.empty()) text << ", silent:" << silent;
+    return text.str();
+  }
+
+  // per-node totals of the run
+  void print(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto& node : mNodes) {
+      const Node& stats = node.second;
+      out << "[renderer] " << node.first << ": " << stats.frames << " frames, "
+          << stats.dropped << " dropped, worst " << stats.worstMs << " ms, "
+          << stats.vertices << " vertices, "
+          << (stats.frames ? 100.0 * stats.cacheHits / stats.frames : 0)
+          << "% mesh cache hits" << std::endl;
+    }
+  }
+
+private:
+  std::mutex mLock;
+  std::map<std::string, Node> mNodes;  // by node name
+};
@@ -0,0 +1,76 @@
+// Timed show scripts for unattended runs: one "<seconds> <command> [argument]"
+// per line, # starts a comment. ShowPlayer replays a script on the primary
+// (--show) and ShowRecorder writes one from the primary's keyboard
+// (--record-show). Commands are the ones MyApp::perform understands.
+
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct ShowEvent {
+  double time;
+  std::string command;
+  std::string argument;
+};
+
+class ShowPlayer {
+public:
+  bool load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+      std::fprintf(stderr, "%s: can't open show\n", path.c_str());
+      return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream words(line);
+      ShowEvent event;
+      if (!(words >> event.time >> event.command)) continue;
+      std::getline(words >> std::ws, event.argument);
+      mEvents.push_back(event);
+    }
+    mNext = 0;
+    return true;
+  }
+
+  // calls perform(event) for every event due at `seconds` into the show
+  template <class Perform>
+  void poll(double seconds, Perform perform) {
+    while (mNext < mEvents.size() && mEvents[mNext].time <= seconds) {
+      perform(mEvents[mNext++]);
+    }
+  }
+
+private:
+  std::vector<ShowEvent> mEvents;  // in file order, times ascending
+  size_t mNext = 0;
+};
+
+class ShowRecorder {
+public:
+  ~ShowRecorder() {
+    if (mFile) std::fclose(mFile);
+  }
+
+  bool open(const std::string& path) {
+    mFile = std::fopen(path.c_str(), "w");
+    if (!mFile) std::fprintf(stderr, "%s: can't record show\n", path.c_str());
+    return mFile;
+  }
+
+  void record(double seconds, const std::string& command,
+              const std::string& argument) {
+    if (!mFile) return;
+    std::fprintf(mFile, "%.3f %s %s\n", seconds, command.c_str(),
+                 argument.c_str());
+    std::fflush(mFile);
+  }
+
+private:
+  FILE* mFile = nullptr;
+};
@@ -0,0 +1,46 @@
+// Logs how long a node takes to reach each startup milestone
+// (window, first frame, sync with primary), measured from process start.
+// Milestones may be marked from any thread.
+
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class StartupTimeline {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // call as early as possible in main()
+  static Clock::time_point processStart() {
+    static const Clock::time_point start = Clock::now();
+    return start;
+  }
+
+  void node(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mNode = name;
+  }
+
+  // records a milestone the first time it is reached
+  void mark(const char* milestone) {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto* reached : mReached) {
+      if (!std::strcmp(reached, milestone)) return;
+    }
+    mReached.push_back(milestone);
+    double ms = std::chrono::duration<double, std::milli>(
+                    Clock::now() - processStart()).count();
+    std::cout << "[startup] " << mNode << " " << milestone << ": " << ms
+              << " ms" << std::endl;
+  }
+
+private:
+  std::mutex mLock;
+  std::string mNode{"node"};
+  std::vector<const char*> mReached;
+};
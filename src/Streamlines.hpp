@@ -0,0 +1,78 @@
+// Grid of streamlines through an attractor's vector field. Seeds are spaced
+// evenly over [-range, range]^3 and traced with the integrate kernel, in
+// parallel on the shared WorkerPool, straight into their slice of one
+// indexed LINES mesh, so the whole flow draws in a single call.
+
+#pragma once
+
+#include <cmath>
+#include "al/graphics/al_VAOMesh.hpp"
+#include "Kernels.hpp"
+#include "WorkerPool.hpp"
+using namespace al;
+
+class Streamlines {
+public:
+  // traces grid^3 streamlines of `steps` Euler steps of attractor `mode`
+  // with the Attractor's p[] values; a line is held at its last point
+  // inside [-bound, bound]^3 once it diverges. Updates the mesh vertices,
+  // not the GPU buffers.
+  void trace(int mode, const float* params, int grid, int steps, float range,
+             float bound) {
+    shape(grid, steps);
+    float* vertices = &lines.vertices()[0][0];
+    WorkerPool::shared().run(grid * grid * grid, [&](int line) {
+      float* points = vertices + 3 * line * (steps + 1);
+      float spacing = grid > 1 ? 2 * range / (grid - 1) : 0;
+      points[0] = -range + spacing * (line % grid);
+      points[1] = -range + spacing * (line / grid % grid);
+      points[2] = -range + spacing * (line / (grid * grid));
+      kernels().integrate(mode, params, steps, points);
+      clamp(points, steps + 1, bound);
+    });
+  }
+
+  int count() const { return lineCount; }
+
+  VAOMesh& mesh() { return lines; }
+
+private:
+  // resizes the mesh and rebuilds its segment indices when the grid or
+  // length changed
+  void shape(int grid, int steps) {
+    if (grid * grid * grid == lineCount && steps == lineSteps) return;
+    lineCount = grid * grid * grid;
+    lineSteps = steps;
+    lines.reset();
+    lines.primitive(Mesh::LINES);
+    lines.vertices().resize(lineCount * (steps + 1));
+    auto& indices = lines.indices();
+    indices.resize(2 * lineCount * steps);
+    unsigned* index = &indices[0];
+    for (int line = 0; line < lineCount; line++) {
+      unsigned first = line * (steps + 1);
+      for (int i = 0; i < steps; i++) {
+        *index++ = first + i;
+        *index++ = first + i + 1;
+      }
+    }
+  }
+
+  static void clamp(float* points, int n, float bound) {
+    for (int i = 1; i < n; i++) {
+      float* point = points + 3 * i;
+      if (!(std::fabs(point[0]) < bound && std::fabs(point[1]) < bound &&
+            std::fabs(point[2]) < bound)) {
+        for (; i < n; i++) {
+          points[3 * i] = point[-3];
+          points[3 * i + 1] = point[-2];
+          points[3 * i + 2] = point[-1];
+        }
+      }
+    }
+  }
+
+  VAOMesh lines;
+  int lineCount = 0;
+  int lineSteps = 0;
+};
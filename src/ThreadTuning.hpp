@@ -0,0 +1,211 @@
+// CPU pinning and SCHED_FIFO priority per thread role, plus memory locking
+// and a per-role report of context switches and page faults read from
+// /proc. Configured with --pin-<role>=<cpu>[,<cpu>...] and
+// --priority-<role>=<1-99>, roles being audio, workers, render and network.
+// Linux only; elsewhere the settings are ignored with a warning. Threads
+// the app doesn't register keep the default scheduler.
+
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class ThreadTuning {
+public:
+  enum Role { AUDIO, WORKERS, RENDER, NETWORK, ROLES };
+
+  static const char* name(Role role) {
+    static const char* names[ROLES] = {"audio", "workers", "render", "network"};
+    return names[role];
+  }
+
+  static ThreadTuning& get() {
+    static ThreadTuning tuning;
+    return tuning;
+  }
+
+  // role name -> cpu list ("2,3") and role name -> priority; unknown role
+  // names are reported, a misspelled one would otherwise do nothing
+  void configure(const std::map<std::string, std::string>& pins,
+                 const std::map<std::string, int>& priorities) {
+    for (auto& pin : pins) checkRole("--pin-", pin.first);
+    for (auto& priority : priorities) checkRole("--priority-", priority.first);
+    for (int role = 0; role < ROLES; role++) {
+      auto pin = pins.find(name(Role(role)));
+      if (pin != pins.end()) {
+        std::istringstream cpus(pin->second);
+        std::string cpu;
+        while (std::getline(cpus, cpu, ',')) {
+          char* end = nullptr;
+          long index = std::strtol(cpu.c_str(), &end, 10);
+          if (cpu.empty() || *end || index < 0 || index >= kMaxCpus) {
+            std::cerr << "Ignoring CPU '" << cpu << "' in --pin-" << name(Role(role))
+                      << " (expected 0-" << kMaxCpus - 1 << ")" << std::endl;
+            continue;
+          }
+          mPolicies[role].cpus.push_back((int)index);
+        }
+      }
+      auto priority = priorities.find(name(Role(role)));
+      if (priority != priorities.end()) {
+        mPolicies[role].priority = priority->second;
+      }
+    }
+  }
+
+  // pins and prioritizes the calling thread and tracks it under role; not
+  // real-time safe, call before entering the thread's hot loop
+  void apply(Role role) { apply(role, currentThread()); }
+
+  // apply(role) unless the calling thread already has a role. allolib's
+  // network threads are only reachable from inside their callbacks, which
+  // also run on whichever thread set the parameter locally.
+  void adopt(Role role) {
+    int thread = currentThread();
+    if (!tracked(thread)) apply(role, thread);
+  }
+
+  // keeps every current and future page resident
+  void lockMemory() {
+#ifdef __linux__
+    if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+      std::cerr << "mlockall failed: " << strerror(errno) << std::endl;
+    }
+#else
+    std::cerr << "Memory locking is only supported on Linux" << std::endl;
+#endif
+  }
+
+  // touches the calling thread's stack so its hot loop doesn't fault on it
+  static void prefaultStack() {
+    volatile char stack[64 * 1024];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+  }
+
+  // context switches and page faults of the tracked threads, per role
+  void report(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (int role = 0; role < ROLES; role++) {
+      long voluntary = 0, involuntary = 0, minor = 0, major = 0;
+      int threads = 0;
+      for (auto& entry : mThreads) {
+        if (entry.second != role) continue;
+        threads++;
+        readCounters(entry.first, voluntary, involuntary, minor, major);
+      }
+      if (!threads) continue;
+      out << "[threads] " << name(Role(role)) << ": " << threads
+          << " threads, " << voluntary << " voluntary / " << involuntary
+          << " involuntary context switches, " << minor << " minor / "
+          << major << " major page faults" << std::endl;
+    }
+  }
+
+private:
+#ifdef __linux__
+  static const int kMaxCpus = CPU_SETSIZE;
+#else
+  static const int kMaxCpus = 1024;
+#endif
+
+  struct Policy {
+    std::vector<int> cpus;
+    int priority = 0;  // 0 keeps the default scheduler
+  };
+
+  static void checkRole(const char* option, const std::string& role) {
+    for (int known = 0; known < ROLES; known++) {
+      if (role == name(Role(known))) return;
+    }
+    std::cerr << "Ignoring " << option << role << ": unknown thread role (audio, "
+              << "workers, render or network)" << std::endl;
+  }
+
+  static int currentThread() {
+#ifdef __linux__
+    return (int)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+  }
+
+  bool tracked(int thread) {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mThreads.count(thread);
+  }
+
+  void apply(Role role, int thread) {
+    const Policy& policy = mPolicies[role];
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mThreads[thread] = role;
+    }
+#ifdef __linux__
+    if (!policy.cpus.empty()) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for (int cpu : policy.cpus) CPU_SET(cpu, &cpus);
+      if (sched_setaffinity(thread, sizeof(cpus), &cpus)) {
+        std::cerr << "Pinning " << name(role) << " thread failed: "
+                  << strerror(errno) << std::endl;
+      }
+    }
+    if (policy.priority > 0) {
+      sched_param param{};
+      param.sched_priority = policy.priority;
+      if (sched_setscheduler(thread, SCHED_FIFO, &param)) {
+        std::cerr << "SCHED_FIFO for " << name(role) << " thread failed: "
+                  << strerror(errno) << " (needs CAP_SYS_NICE or rtprio)"
+                  << std::endl;
+      }
+    }
+#else
+    if (!policy.cpus.empty() || policy.priority > 0) {
+      std::cerr << "Thread tuning is only supported on Linux" << std::endl;
+    }
+#endif
+  }
+
+  static void readCounters(int thread, long& voluntary, long& involuntary,
+                           long& minor, long& major) {
+    std::string task = "/proc/self/task/" + std::to_string(thread);
+    std::ifstream status(task + "/status");
+    std::string key;
+    long value;
+    while (status >> key) {
+      if (key == "voluntary_ctxt_switches:" && status >> value) voluntary += value;
+      if (key == "nonvoluntary_ctxt_switches:" && status >> value) involuntary += value;
+    }
+
+    // fields after the parenthesized name; minflt and majflt are 10 and 12
+    std::ifstream stat(task + "/stat");
+    std::string line;
+    std::getline(stat, line);
+    auto fields = line.find(')');
+    if (fields == std::string::npos) return;
+    std::istringstream rest(line.substr(fields + 2));
+    std::string field;
+    for (int i = 3; rest >> field && i <= 12; i++) {
+      if (i == 10) minor += std::stol(field);
+      if (i == 12) major += std::stol(field);
+    }
+  }
+
+  Policy mPolicies[ROLES];
+  std::mutex mLock;
+  std::map<int, int> mThreads;  // thread id -> role
+};
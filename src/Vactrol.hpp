@@ -0,0 +1,57 @@
+// Envelope follower after giml::Vactrol, which it replaces, with its curve
+// and defaults: a one-pole that rises with a 10 ms and falls with a 500 ms
+// time constant (bench --vactrol-check compares the two). giml only takes
+// the sample rate at construction; here setSampleRate() recomputes both
+// coefficients for the rate the stream actually runs at, so the per-sample
+// work stays one compare and one multiply-add.
+
+#pragma once
+
+#include <cmath>
+
+class Vactrol {
+public:
+  explicit Vactrol(double sampleRate) { setSampleRate(sampleRate); }
+
+  // recomputes the coefficients; call before the stream starts or from
+  // the audio thread itself
+  void setSampleRate(double sampleRate) {
+    mSampleRate = sampleRate;
+    mAttack = coefficient(kAttackMs);
+    mRelease = coefficient(kReleaseMs);
+  }
+
+  double sampleRate() const { return mSampleRate; }
+
+  // input is a rectified level, nominally 0 to 1; anything non-finite is
+  // taken as silence so one bad sample can't stick the state at NaN
+  float operator()(float input) {
+    if (!std::isfinite(input)) input = 0;
+    float k = input > mState ? mAttack : mRelease;
+    mState += k * (input - mState);
+    // the release decays towards 0 on silence and would settle in the
+    // denormal range; snap it, FTZ or not
+    if (std::fabs(mState) < kDenormalFloor) mState = 0;
+    return mState;
+  }
+
+  void reset() { mState = 0; }
+
+  // giml's defaults
+  static constexpr double kAttackMs = 10, kReleaseMs = 500;
+
+private:
+  // 1 - e^(-1 / (t fs)), the step towards the input per sample. Kept as
+  // the step rather than the pole, which at 500 ms and 96 kHz sits so
+  // close to 1 that a float only holds it to 0.3%.
+  float coefficient(double ms) const {
+    return (float)-std::expm1(-1 / (ms * 0.001 * mSampleRate));
+  }
+
+  // far below anything audible or visible in h, far above FLT_MIN
+  static constexpr float kDenormalFloor = 1e-15f;
+
+  double mSampleRate = 0;
+  float mAttack = 0, mRelease = 0;
+  float mState = 0;
+};
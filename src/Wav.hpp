@@ -0,0 +1,219 @@
+// Minimal WAV file access for the offline audio backends. WavReader maps the
+// file (POSIX mmap, whole-file read elsewhere) and converts blocks on demand,
+// so long recordings stream from the page cache; WavWriter streams 32-bit
+// float frames and patches the header sizes on close.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class WavReader {
+public:
+  ~WavReader() { close(); }
+
+  // supports PCM 16/24/32 bit and 32-bit float, plain or extensible
+  bool open(const std::string& path) {
+    close();
+    if (!map(path)) return false;
+
+    const uint8_t* end = mData + mSize;
+    uint64_t dataBytes = 0;
+    if (mSize < 12 || std::memcmp(mData, "RIFF", 4) ||
+        std::memcmp(mData + 8, "WAVE", 4)) {
+      return fail(path, "not a RIFF/WAVE file");
+    }
+    for (const uint8_t* chunk = mData + 12; chunk + 8 <= end;) {
+      uint32_t size = u32(chunk + 4);
+      const uint8_t* body = chunk + 8;
+      if (!std::memcmp(chunk, "fmt ", 4) && size >= 16) {
+        mFormat = u16(body);
+        mChannels = u16(body + 2);
+        mSampleRate = u32(body + 4);
+        mBits = u16(body + 14);
+        if (mFormat == 0xFFFE && size >= 26) mFormat = u16(body + 24);
+      } else if (!std::memcmp(chunk, "data", 4)) {
+        // the frame size comes from fmt, so it has to come first
+        if (!mChannels) return fail(path, "no fmt chunk before the data");
+        mSamples = body;
+        uint64_t available = end - body;
+        dataBytes = size < available ? size : available;
+        break;
+      }
+      chunk = body + size + (size & 1);
+    }
+
+    bool pcm = mFormat == 1 && (mBits == 16 || mBits == 24 || mBits == 32);
+    bool flt = mFormat == 3 && mBits == 32;
+    if (!mSamples) return fail(path, "no data chunk");
+    if (!(pcm || flt)) return fail(path, "unsupported sample format");
+    mFrames = dataBytes / (mChannels * (mBits / 8));
+    if (!mFrames) return fail(path, "no sample frames");
+#ifndef _WIN32
+    madvise((void*)mData, mSize, MADV_SEQUENTIAL);
+#endif
+    return true;
+  }
+
+  void close() {
+#ifndef _WIN32
+    if (mData) munmap((void*)mData, mSize);
+#endif
+    mCopy.clear();
+    mData = mSamples = nullptr;
+    mSize = mFrames = 0;
+    mFormat = mChannels = mSampleRate = mBits = 0;
+  }
+
+  int channels() const { return mChannels; }
+  int sampleRate() const { return mSampleRate; }
+  uint64_t frames() const { return mFrames; }
+
+  // n frames of one channel starting at frame, looping at the end
+  void read(int channel, uint64_t frame, int n, float* out) const {
+    const int stride = mChannels * (mBits / 8);
+    channel %= mChannels;
+    for (int i = 0; i < n; i++) {
+      const uint8_t* s =
+          mSamples + ((frame + i) % mFrames) * stride + channel * (mBits / 8);
+      out[i] = sample(s);
+    }
+  }
+
+private:
+  bool map(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info)) {
+      if (fd >= 0) ::close(fd);
+      return fail(path, "can't open");
+    }
+    mSize = info.st_size;
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return fail(path, "can't map");
+    mData = static_cast<const uint8_t*>(data);
+#else
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return fail(path, "can't open");
+    std::fseek(file, 0, SEEK_END);
+    mCopy.resize(std::ftell(file));
+    std::fseek(file, 0, SEEK_SET);
+    mSize = std::fread(mCopy.data(), 1, mCopy.size(), file);
+    std::fclose(file);
+    mData = mCopy.data();
+#endif
+    return true;
+  }
+
+  float sample(const uint8_t* s) const {
+    if (mFormat == 3) {
+      float value;
+      std::memcpy(&value, s, 4);
+      return value;
+    }
+    if (mBits == 16) return int16_t(u16(s)) / 32768.f;
+    if (mBits == 24) return int32_t(u32(s - 1) & 0xFFFFFF00) / 2147483648.f;
+    return int32_t(u32(s)) / 2147483648.f;
+  }
+
+  bool fail(const std::string& path, const char* why) {
+    std::fprintf(stderr, "%s: %s\n", path.c_str(), why);
+    close();
+    return false;
+  }
+
+  static uint16_t u16(const uint8_t* p) { return p[0] | p[1] << 8; }
+  static uint32_t u32(const uint8_t* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | uint32_t(p[3]) << 24;
+  }
+
+  const uint8_t* mData = nullptr;
+  const uint8_t* mSamples = nullptr;
+  std::vector<uint8_t> mCopy;  // without mmap
+  uint64_t mSize = 0;
+  uint64_t mFrames = 0;
+  int mFormat = 0, mChannels = 0, mSampleRate = 0, mBits = 0;
+};
+
+class WavWriter {
+public:
+  ~WavWriter() { close(); }
+
+  bool open(const std::string& path, int channels, int sampleRate) {
+    mFile = std::fopen(path.c_str(), "wb");
+    if (!mFile) {
+      std::fprintf(stderr, "%s: can't open for writing\n", path.c_str());
+      return false;
+    }
+    mChannels = channels;
+    mSampleRate = sampleRate;
+    mFrames = 0;
+    writeHeader();  // sizes patched in close()
+    return true;
+  }
+
+  // one block of deinterleaved channels
+  void write(const float* const* channels, int frames) {
+    if (!mFile) return;
+    mInterleaved.resize(frames * mChannels);
+    for (int i = 0; i < frames; i++) {
+      for (int c = 0; c < mChannels; c++) {
+        mInterleaved[i * mChannels + c] = channels[c][i];
+      }
+    }
+    std::fwrite(mInterleaved.data(), sizeof(float), mInterleaved.size(), mFile);
+    mFrames += frames;
+  }
+
+  bool isOpen() const { return mFile; }
+
+  void close() {
+    if (!mFile) return;
+    std::fseek(mFile, 0, SEEK_SET);
+    writeHeader();
+    std::fclose(mFile);
+    mFile = nullptr;
+  }
+
+private:
+  void writeHeader() {
+    uint32_t dataBytes = uint32_t(mFrames * mChannels * 4);
+    uint8_t header[44];
+    std::memcpy(header, "RIFF", 4);
+    put32(header + 4, 36 + dataBytes);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    put32(header + 16, 16);
+    put16(header + 20, 3);  // IEEE float
+    put16(header + 22, mChannels);
+    put32(header + 24, mSampleRate);
+    put32(header + 28, mSampleRate * mChannels * 4);
+    put16(header + 32, mChannels * 4);
+    put16(header + 34, 32);
+    std::memcpy(header + 36, "data", 4);
+    put32(header + 40, dataBytes);
+    std::fwrite(header, 1, sizeof(header), mFile);
+  }
+
+  static void put16(uint8_t* p, uint32_t v) { p[0] = v, p[1] = v >> 8; }
+  static void put32(uint8_t* p, uint32_t v) {
+    put16(p, v);
+    put16(p + 2, v >> 16);
+  }
+
+  FILE* mFile = nullptr;
+  int mChannels = 0, mSampleRate = 0;
+  uint64_t mFrames = 0;
+  std::vector<float> mInterleaved;
+};
@@ -0,0 +1,112 @@
+// Fixed pool of worker threads for data-parallel loops split into chunks.
+// run() hands out chunk indices from an atomic counter tagged with the
+// job's generation, works on chunks itself as well and returns once all of
+// them are done. A worker that wakes late only ever claims chunks of the
+// job it was woken for, and fails its claim once that job is over. Workers take the
+// ThreadTuning workers role, so --pin-workers / --priority-workers apply.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ThreadTuning.hpp"
+
+class WorkerPool {
+public:
+  // one worker per core besides the calling thread
+  static WorkerPool& shared() {
+    static WorkerPool pool((int)std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+  }
+
+  explicit WorkerPool(int workers) {
+    for (int i = 0; i < workers; i++) {
+      mWorkers.emplace_back([this]() { loop(); });
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mStop = true;
+    }
+    mWake.notify_all();
+    for (auto& worker : mWorkers) worker.join();
+  }
+
+  // threads run() spreads work over, including the caller
+  int threads() const { return (int)mWorkers.size() + 1; }
+
+  // calls task(0) .. task(chunks - 1) across the pool; not reentrant
+  void run(int chunks, const std::function<void(int)>& task) {
+    if (chunks <= 0) return;
+    uint32_t generation;
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mTask = &task;
+      mChunks = chunks;
+      mPending = chunks;
+      generation = ++mGeneration;
+      mNext = uint64_t(generation) << 32;
+    }
+    mWake.notify_all();
+    work(generation, task, chunks);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    mDone.wait(lock, [this]() { return mPending == 0; });
+  }
+
+private:
+  void loop() {
+    ThreadTuning::get().apply(ThreadTuning::WORKERS);
+    uint32_t seen = 0;
+    while (true) {
+      const std::function<void(int)>* task;
+      int chunks;
+      {
+        std::unique_lock<std::mutex> lock(mLock);
+        mWake.wait(lock, [&]() { return mStop || mGeneration != seen; });
+        if (mStop) return;
+        seen = mGeneration;
+        task = mTask;
+        chunks = mChunks;
+      }
+      work(seen, *task, chunks);
+    }
+  }
+
+  // claims chunks of job generation until none are left. A claim is one
+  // compare-exchange on generation and index together, so it fails once
+  // run() has moved on, and task is only called for a claimed chunk,
+  // while run() is still waiting for it.
+  void work(uint32_t generation, const std::function<void(int)>& task, int chunks) {
+    uint64_t next = mNext.load();
+    while (true) {
+      if (uint32_t(next >> 32) != generation || int(uint32_t(next)) >= chunks) return;
+      if (!mNext.compare_exchange_weak(next, next + 1)) continue;
+      task(int(uint32_t(next)));
+      if (mPending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mDone.notify_all();
+      }
+      next = mNext.load();
+    }
+  }
+
+  std::vector<std::thread> mWorkers;
+  std::mutex mLock;
+  std::condition_variable mWake, mDone;
+  // the current job, set by run() and read by workers under mLock
+  const std::function<void(int)>* mTask = nullptr;
+  int mChunks = 0;
+  uint32_t mGeneration = 0;
+  std::atomic<uint64_t> mNext{0};  // generation << 32 | next chunk
+  std::atomic<int> mPending{0};    // chunks of the current job not done
+  bool mStop = false;
+};
@@ -0,0 +1,470 @@
+// Headless attractor benchmark: times Attractor::compute() (integration,
+// ribbonize and normals) in every mode with the values of preset 7, then
+// the particle cloud, the streamline overlay, a geometry morph and coupled
+// systems.
+// Also reports the throughput of every kernel variant the CPU supports.
+// Usage: Allolib-Kickstart-bench [frames]
+//        Allolib-Kickstart-bench --rt-check  (needs ALLOSKETCH_RT_CHECK)
+//        Allolib-Kickstart-bench --load-test [audio load threshold]
+//        Allolib-Kickstart-bench --denormals
+//        Allolib-Kickstart-bench --ribbon-check
+//        Allolib-Kickstart-bench --vactrol-check
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "al/io/al_Socket.hpp"
+#include "Attractor.hpp"
+#include "AudioReactor.hpp"
+#include "Denormals.hpp"
+#include "FrameArena.hpp"
+#include "Kernels.hpp"
+#include "OfflineAudio.hpp"
+#include "RealtimeSafety.hpp"
+#include "Vactrol.hpp"
+#include "WorkerPool.hpp"
+
+// the reference for --vactrol-check, when the submodule is checked out
+#if defined(__has_include)
+#if __has_include("../gimmel/include/gimmel.hpp")
+#include "../gimmel/include/gimmel.hpp"
+#define ALLOSKETCH_HAVE_GIML
+#endif
+#endif
+
+namespace {
+
+struct PresetValue {
+  const char* name;
+  float value;
+};
+
+// presets/7.preset
+const PresetValue kPreset7[] = {
+  {"N", 100000},    {"h", 0.003},     {"x0", 0.248},   {"y0", 2.298},
+  {"z0", 4.845},    {"rho", 27.652},  {"sigma", 10},   {"beta", 1.975},
+  {"a", 29.783},    {"b", -0.124},    {"c", -10},      {"d", -10},
+  {"e", -4.161},    {"o", 0.373},     {"g", 8.385},
+};
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// runs the attractor and envelope kernels of one variant directly
+void benchKernels(const Kernels& k, int frames) {
+  float params[15];
+  for (int i = 0; i < 15; i++) params[i] = kPreset7[i].value;
+  const int n = 20000;  // largest N the Attractor allows
+  std::vector<float> points(3 * (n + 1)), vertices(6 * (n + 1)),
+      normals(6 * (n + 1)), faces(6 * (n + 1));
+
+  auto start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    points[0] = params[2], points[1] = params[3], points[2] = params[4];
+    k.integrate(frame % 4, params, n, points.data());
+    k.ribbon(points.data(), n + 1, 0.07f, nullptr, vertices.data());
+    k.stripNormals(vertices.data(), 2 * (n + 1), faces.data(), normals.data());
+  }
+  double pipelineMs = msSince(start) / frames;
+
+  // geometry cost per output vertex: ribbon plus normals vs an 8 sided tube
+  const int sides = 8;
+  std::vector<float> tubeVertices(3 * sides * (n + 1)), tubeNormals(3 * sides * (n + 1));
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    k.ribbon(points.data(), n + 1, 0.07f, nullptr, vertices.data());
+    k.stripNormals(vertices.data(), 2 * (n + 1), faces.data(), normals.data());
+  }
+  double ribbonNs = msSince(start) * 1e6 / frames / (2 * (n + 1));
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    k.tube(points.data(), n + 1, 0.07f, nullptr, sides, tubeVertices.data(),
+           tubeNormals.data());
+  }
+  double tubeNs = msSince(start) * 1e6 / frames / (sides * (n + 1));
+
+  // one second of a 441 Hz sine, enveloped in 256 frame blocks
+  std::vector<float> input(44100), envelope(256);
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = std::sin(6.2831853 * 441 * i / 44100.0);
+  }
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    for (size_t i = 0; i + 256 <= input.size(); i += 256) {
+      k.rectify(input.data() + i, 256, envelope.data());
+      k.warp(envelope.data(), 256, 0.007f);
+    }
+  }
+  double envelopeMs = msSince(start) / frames;
+
+  // one Particles chunk on one thread
+  const int chunk = 16384, steps = 4;
+  std::vector<float> x(chunk), y(chunk), z(chunk);
+  k.advect(0, params, 0, chunk, x.data(), y.data(), z.data(), 0, 10, 0);
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    k.advect(frame % 4, params, steps, chunk, x.data(), y.data(), z.data(),
+             1000, 10, frame * chunk);
+  }
+  double advectMs = msSince(start) / frames;
+
+  std::printf("%-8s %s pipeline %8.3f ms/frame, envelope %8.1f Msamples/s, "
+              "advect %8.1f Msteps/s, ns/vertex ribbon %5.2f tube %5.2f\n",
+              k.isa, &k == &kernels() ? "*" : " ", pipelineMs,
+              input.size() / (envelopeMs * 1000.0),
+              chunk * steps / (advectMs * 1000.0), ribbonNs, tubeNs);
+}
+
+// drives the primary's onSound (AudioReactor::prepareThread and callback)
+// with synthetic blocks; fails on any real-time safety violation
+int realtimeCheck() {
+#ifndef ALLOSKETCH_RT_CHECK
+  std::printf("rt check not compiled in, configure with -DALLOSKETCH_RT_CHECK=ON\n");
+  return 2;
+#else
+  AudioReactor audio{44100};
+  AudioIOData io;
+  io.framesPerSecond(44100);
+  io.framesPerBuffer(256);
+  io.channelsIn(9);
+  io.channelsOut(60);
+
+  // loud, then silent, so attack and release both run
+  float* in = const_cast<float*>(io.inBuffer(0));
+  for (int block = 0; block < 2000; block++) {
+    for (int i = 0; i < 256; i++) {
+      in[i] = block < 1000 ? std::sin(6.2831853 * 441 * i / 44100.0) : 0;
+    }
+    audio.prepareThread(io);
+    audio.callback(io);
+  }
+
+  size_t violations = realtimeViolations();
+  std::printf("rt check: %zu violations in 2000 blocks\n", violations);
+  return violations ? 1 : 0;
+#endif
+}
+
+// compares every kernel variant's ribbon with allolib's
+// Mesh::ribbonize(width, true), which it replaces, on a short curve
+int ribbonCheck() {
+  const int n = 64;
+  const float width = 0.07f;
+  Mesh reference;
+  std::vector<float> points(3 * n);
+  for (int i = 0; i < n; i++) {
+    float t = 0.3f * i;
+    points[3 * i] = 3 + 2 * std::cos(t);
+    points[3 * i + 1] = 1 + 2 * std::sin(t);
+    points[3 * i + 2] = 0.5f * t;
+    reference.vertex(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+  }
+  reference.ribbonize(width, true);
+
+  int failures = 0;
+  for (auto* variant : supportedKernels()) {
+    std::vector<float> vertices(6 * n);
+    variant->ribbon(points.data(), n, width, nullptr, vertices.data());
+    float worst = 0;
+    for (int i = 0; i < 2 * n; i++) {
+      for (int k = 0; k < 3; k++) {
+        worst = std::max(worst, std::fabs(vertices[3 * i + k] - reference.vertices()[i][k]));
+      }
+    }
+    bool ok = worst < 1e-4f;
+    failures += !ok;
+    std::printf("ribbon check %-8s max deviation from ribbonize %g %s\n",
+                variant->isa, worst, ok ? "ok" : "FAILED");
+  }
+  return failures ? 1 : 0;
+}
+
+// Checks the Vactrol at several rates: its step response against the
+// 10 ms / 500 ms time constants, a NaN input, and, with gimmel checked
+// out, every sample of a bursty test signal against giml::Vactrol.
+int vactrolCheck() {
+  int failures = 0;
+  for (int rate : {44100, 48000, 96000}) {
+    // samples until a step from 0 to 1 and back crosses 1 - 1/e and 1/e
+    Vactrol vactrol(rate);
+    int rise = 0, fall = 0;
+    while (vactrol(1) < 1 - std::exp(-1.0)) rise++;
+    for (int i = 0; i < rate; i++) vactrol(1);  // settle at 1
+    while (vactrol(0) > std::exp(-1.0)) fall++;
+    double attackMs = 1000.0 * (rise + 1) / rate;
+    double releaseMs = 1000.0 * (fall + 1) / rate;
+    // within two samples, the discrete pole lagging the continuous one
+    bool timed = std::fabs(attackMs - Vactrol::kAttackMs) < 2000.0 / rate &&
+                 std::fabs(releaseMs - Vactrol::kReleaseMs) < 2000.0 / rate;
+    vactrol(std::nanf(""));
+    bool finite = std::isfinite(vactrol(0.5f));
+    bool ok = timed && finite;
+    std::printf("vactrol check %6d Hz: attack %.3f ms, release %.3f ms %s, NaN input %s",
+                rate, attackMs, releaseMs, timed ? "ok" : "FAILED",
+                finite ? "ok" : "FAILED");
+
+#ifdef ALLOSKETCH_HAVE_GIML
+    // rectified 441 Hz bursts of falling level with gaps between them
+    Vactrol ported(rate);
+    giml::Vactrol<float> reference(rate);
+    float worst = 0;
+    for (int i = 0; i < 3 * rate; i++) {
+      double t = double(i) / rate;
+      float level = std::fmod(t, 0.75) < 0.25 ? float(0.9 - 0.25 * std::floor(t / 0.75)) : 0;
+      float input = std::fabs(level * float(std::sin(6.2831853 * 441 * t)));
+      worst = std::max(worst, std::fabs(ported(input) - reference(input)));
+    }
+    bool same = worst < 1e-3f;
+    ok = ok && same;
+    std::printf(", max deviation from giml %g %s", worst, same ? "ok" : "FAILED");
+#endif
+    std::printf("\n");
+    failures += !ok;
+  }
+  return failures ? 1 : 0;
+}
+
+// Ramps voice count and N through the real Attractor pipeline, with the
+// audio path running in real time on its own thread, until a frame takes
+// longer than 16.6 ms or the audio callback load passes the threshold.
+// Writes capacity-<host>.txt. GPU upload and draw aren't included.
+int loadTest(double audioThreshold) {
+  const double frameBudgetMs = 1000.0 / 60;
+  const int steps[] = {2500, 5000, 10000, 20000};
+  const int maxVoices = 64;
+  const int frames = 30;
+
+  std::vector<std::unique_ptr<Attractor>> voices;
+  for (int v = 0; v < maxVoices; v++) {
+    voices.emplace_back(new Attractor);
+    voices[v]->init();
+    for (auto& preset : kPreset7) {
+      voices[v]->parameter(preset.name)->fromFloat(preset.value);
+    }
+    voices[v]->setMode(v % 4);
+  }
+
+  AudioReactor audio{44100};
+  OfflineAudio driver;
+  driver.configure(44100, 256, 60, 9);  // the primary's AUDIO_CONFIG
+  driver.start([&audio](AudioIOData& io) { audio.process(io); }, true);
+
+  std::string host = Socket::hostName();
+  std::ofstream report("capacity-" + host + ".txt");
+  report << "# attractor capacity of " << host << " (" << kernels().isa
+         << " kernels), budget " << frameBudgetMs << " ms/frame, audio load "
+         << audioThreshold << "\n# N voices frame_ms worst_ms audio_load\n";
+
+  for (int n : steps) {
+    int capacity = 0;
+    for (int count = 1; count <= maxVoices; count *= 2) {
+      for (int v = 0; v < count; v++) {
+        voices[v]->parameter("N")->fromFloat(n);
+      }
+
+      driver.takeLoad();
+      double totalMs = 0, worstMs = 0;
+      for (int frame = 0; frame < frames; frame++) {
+        auto start = Clock::now();
+        for (int v = 0; v < count; v++) {
+          voices[v]->invalidate(Attractor::INTEGRATE);
+          voices[v]->compute();
+        }
+        FrameArena::local().reset();
+        double ms = msSince(start);
+        totalMs += ms;
+        worstMs = std::max(worstMs, ms);
+      }
+      double frameMs = totalMs / frames;
+      double load = driver.takeLoad();
+
+      report << n << " " << count << " " << frameMs << " " << worstMs << " "
+             << load << "\n";
+      std::printf("N %5d voices %2d: %8.3f ms/frame (worst %8.3f), audio load %.3f\n",
+                  n, count, frameMs, worstMs, load);
+      if (frameMs > frameBudgetMs || load > audioThreshold) break;
+      capacity = count;
+    }
+    report << "capacity N=" << n << " voices=" << capacity << "\n";
+    std::printf("capacity at N %d: %d voices\n", n, capacity);
+  }
+
+  driver.stop();
+  std::printf("wrote capacity-%s.txt\n", host.c_str());
+  return 0;
+}
+
+// Times the audio path per block on a signal and on the silence after it,
+// once the envelope has had time to decay, with FTZ/DAZ off and on. The
+// Vactrol snaps its own state, so both should cost the same; a slower
+// silence with FTZ/DAZ off means some state escaped into denormals.
+int denormalCheck() {
+  const int blocks = 2000;
+  const int decay = 8000;  // ~46 s of silence before timing it
+
+  for (int flush = 0; flush < 2; flush++) {
+    flushDenormals(flush);
+    AudioReactor audio{44100};
+    AudioIOData io;
+    io.framesPerSecond(44100);
+    io.framesPerBuffer(256);
+    io.channelsIn(9);
+    io.channelsOut(60);
+    float* in = const_cast<float*>(io.inBuffer(0));
+
+    for (int i = 0; i < 256; i++) {
+      in[i] = std::sin(6.2831853 * 441 * i / 44100.0);
+    }
+    auto start = Clock::now();
+    for (int block = 0; block < blocks; block++) audio.process(io);
+    double signalUs = msSince(start) * 1000 / blocks;
+
+    std::fill(in, in + 256, 0.f);
+    for (int block = 0; block < decay; block++) audio.process(io);
+    start = Clock::now();
+    for (int block = 0; block < blocks; block++) audio.process(io);
+    double silenceUs = msSince(start) * 1000 / blocks;
+
+    std::printf("FTZ/DAZ %s: signal %7.2f us/block, silence %7.2f us/block (%.2fx)\n",
+                flush ? "on " : "off", signalUs, silenceUs, silenceUs / signalUs);
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && !std::strcmp(argv[1], "--rt-check")) {
+    return realtimeCheck();
+  }
+  if (argc > 1 && !std::strcmp(argv[1], "--load-test")) {
+    return loadTest(argc > 2 ? std::atof(argv[2]) : 0.5);
+  }
+  if (argc > 1 && !std::strcmp(argv[1], "--denormals")) {
+    return denormalCheck();
+  }
+  if (argc > 1 && !std::strcmp(argv[1], "--ribbon-check")) {
+    return ribbonCheck();
+  }
+  if (argc > 1 && !std::strcmp(argv[1], "--vactrol-check")) {
+    return vactrolCheck();
+  }
+  int frames = argc > 1 ? std::atoi(argv[1]) : 50;
+
+  std::printf("kernel variants (* = selected for this CPU):\n");
+  for (auto* variant : supportedKernels()) {
+    benchKernels(*variant, frames);
+  }
+
+  Attractor attractor;
+  attractor.init();
+  for (auto& preset : kPreset7) {
+    attractor.parameter(preset.name)->fromFloat(preset.value);
+  }
+
+  double totalMs = 0;
+  for (int mode = 0; mode < 4; mode++) {
+    attractor.setMode(mode);
+    attractor.compute();  // warm up caches and mesh storage
+
+    auto start = Clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+      attractor.invalidate(Attractor::INTEGRATE);
+      attractor.compute();
+      FrameArena::local().reset();
+    }
+    double ms = msSince(start) / frames;
+
+    // what a width slider drag costs
+    start = Clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+      attractor.invalidate(Attractor::RIBBON);
+      attractor.compute();
+      FrameArena::local().reset();
+    }
+    double ribbonMs = msSince(start) / frames;
+
+    std::printf("mode %d: %8.3f ms/frame %8.2f Msteps/s, ribbon only %8.3f ms\n",
+                mode, ms, attractor.steps() / (ms * 1000.0), ribbonMs);
+    totalMs += ms;
+  }
+
+  // particle mode, across the worker pool
+  attractor.advect();  // allocates and seeds the cloud
+  int reseeded = 0;
+  auto start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    reseeded += attractor.advect();
+  }
+  double particleMs = msSince(start) / frames;
+  std::printf("particles: %d on %d threads, %8.3f ms/frame, %d reseeded/frame\n",
+              attractor.particleCount(), WorkerPool::shared().threads(),
+              particleMs, reseeded / frames);
+
+  // streamline overlay at its default grid, on top of the orbit
+  attractor.parameter("streamlines")->fromFloat(1);
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    attractor.invalidate(Attractor::INTEGRATE);
+    attractor.compute();
+    FrameArena::local().reset();
+  }
+  double streamlineMs = msSince(start) / frames;
+  attractor.parameter("streamlines")->fromFloat(0);
+  std::printf("streamlines: %d with the orbit, %8.3f ms/frame\n",
+              attractor.streamlineCount(), streamlineMs);
+
+  // geometry morph between the orbits of modes 0 and 1: a blend and a
+  // ribbon per frame, no integration
+  attractor.setMode(0);
+  attractor.invalidate(Attractor::INTEGRATE);
+  attractor.requestCapture(Morph::A);
+  attractor.compute();
+  attractor.setMode(1);
+  attractor.invalidate(Attractor::INTEGRATE);
+  attractor.requestCapture(Morph::B);
+  attractor.compute();
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    attractor.parameter("morph")->fromFloat((frame + 1.f) / frames);
+    attractor.invalidate(Attractor::RIBBON);
+    attractor.compute();
+    FrameArena::local().reset();
+  }
+  double morphMs = msSince(start) / frames;
+  attractor.parameter("morph")->fromFloat(0);
+  std::printf("morph: %8.3f ms/frame\n", morphMs);
+
+  // kMaxCoupled coupled copies, integrated together in SIMD lanes
+  attractor.parameter("coupled")->fromFloat(kMaxCoupled);
+  start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    attractor.invalidate(Attractor::INTEGRATE);
+    attractor.compute();
+    FrameArena::local().reset();
+  }
+  double coupledMs = msSince(start) / frames;
+  attractor.parameter("coupled")->fromFloat(1);
+  std::printf("coupled: %d systems, %8.3f ms/frame (%.3f ms per system)\n",
+              kMaxCoupled, coupledMs, coupledMs / kMaxCoupled);
+
+  auto& arena = FrameArena::local();
+  std::printf("frame arena: %zu KB per frame, %zu KB capacity, %zu heap fallbacks\n",
+              arena.lastFrameBytes() / 1024, arena.capacity() / 1024,
+              arena.overflows());
+
+  // summary line parsed by bench.sh
+  std::printf("frame: %.3f ms\n", totalMs / 4);
+  return 0;
+}
@@ -19,196 +19,403 @@
   #define SPEAKER_LAYOUT al::AlloSphereSpeakerLayoutCompensated()
 #endif
 
+// RENDERER_ONLY is defined by the Allolib-Kickstart-renderer target, which
+// compiles out GUI, audio I/O and preset handling for the render cluster
+
+// Attractor voices allocated up front on every node
+#define VOICE_POOL_SIZE 4
+
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <cstdio>  // for printing to stdout
+#include <memory>
+#include <mutex>
+#include <string>
 #include "al/app/al_App.hpp"
 #include "al/app/al_DistributedApp.hpp"
-#include "al/app/al_GUIDomain.hpp"
 #include "al/graphics/al_Shapes.hpp"
-#include "al/io/al_AudioIO.hpp"
+#include "al/io/al_Socket.hpp"
 #include "al/math/al_Random.hpp"
+#include "al/protocol/al_OSC.hpp"
 #include "al/scene/al_DistributedScene.hpp"
 #include "al/scene/al_PolySynth.hpp"
 #include "al/scene/al_SynthSequencer.hpp"
-#include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
+#ifndef RENDERER_ONLY
+#include "al/app/al_GUIDomain.hpp"
+#include "al/io/al_AudioIO.hpp"
+#include "al/io/al_Imgui.hpp"
+#include "al/ui/al_ControlGUI.hpp"
+#endif
 using namespace al;
 
-#include "../gimmel/include/gimmel.hpp"
-
-class Attractor : public PositionedVoice {
-private:
-  static const int P = 15, D = 10;
-  Parameter p[P]{
-    {"N", "p", 10000, 0, 20000},    // p[0] = N     | (simulation steps)
-    {"h", "p", 0.01, 0, 0.018},     // p[1] = h     | (simulation time step)
-    {"x0", "p", 0, -D, D},          // p[2] = x0    | initial
-    {"y0", "p", 0.1, -D, D},        // p[3] = y0    | conditions
-    {"z0", "p", 0, -D, D},          // p[4] = z0    |
-    {"rho", "p", 28, 0, 56},        // p[5] = rho   | simulation
-    {"sigma", "p", 10, 0, 20},      // p[6] = sigma | parameters
-    {"beta", "p", 8.0f / 3, 0, 4},  // p[7] = beta  |
-    {"a", "p", 5, -D, 60},          // p[8] = a     |
-    {"b", "p", -10, -D, D},         // p[9] = b     |
-    {"c", "p", -10, -D, D},         // p[10] = c    |
-    {"d", "p", -10, -D, D},         // p[11] = d    |
-    {"e", "p", -10, -D, D},         // p[12] = e    |
-    {"o", "p", -10, -D, D},         // p[13] = o    |
-    {"g", "p", -10, -D, D},         // p[14] = g    |
-  };
-
-  Parameter width {"width", "", 0.07, 0, 0.2};
-  Parameter gain {"gain", "", -90, -90, 0};
-  ParameterBool light {"light", "", false};  // switch light
-  ParameterInt mode {"mode", "", 0, 0, 3};
-  Mesh system, point;
-
-public:
-
-  void audioInput(float value) {
-    this->p[1] = value;
-  }
+#include "Attractor.hpp"
+#ifndef RENDERER_ONLY
+#include "AudioReactor.hpp"
+#include "Exporter.hpp"
+#include "OfflineAudio.hpp"
+#include "PresetStore.hpp"
+#include "Show.hpp"
+#endif
+#include "FrameArena.hpp"
+#include "Metrics.hpp"
+#include "NodeReport.hpp"
+#include "Options.hpp"
+#include "RendererStats.hpp"
+#include "StartupTimeline.hpp"
+#include "ThreadTuning.hpp"
 
-  void init() override {
-    for (int i = 0; i < P; i++) {
-      this->registerParameter(p[i]);
+struct MyApp : public DistributedApp {  // use simple app if not distributed
+  Options options;
+  StartupTimeline timeline;
+  DistributedScene scene;
+  Attractor* mAttractor = nullptr;
+  bool mAttractorTriggered = false;
+
+  // harness measurements (cluster.sh); the primary stamps "<ns> sync" every
+  // half second and "<ns> apply <seq>" after each command, whose number the
+  // attractor also carries (Attractor::markApplied)
+  NodeReport report;
+  ParameterString showStamp{"showStamp"};
+  std::mutex stampLock;
+  int applySeq = 0;                          // primary, last command number
+  std::map<int, uint64_t> pendingApplies;    // renderers, seq -> sent ns
+  int rebuiltSeq = 0;                        // renderers, last command rebuilt
+  uint64_t rebuiltNs = 0;                    // renderers, when that rebuild ended
+  uint64_t lastRebuilds = 0;
+  double elapsed = 0;
+  double nextHeartbeat = 0;
+  std::unique_ptr<MetricsSink> metricsSink;  // --metrics
+
+  // renderers send "<node> <frames> ..." every half second, the primary
+  // shows the slowest in the GUI (see RendererStats.hpp)
+  std::unique_ptr<ParameterString> rendererStats;  // renderers, grouped by node
+  RendererStats frameStats;  // renderers
+  RendererBoard renderers;   // primary
+
+  // Each renderer's stats parameter lives under its own node name and the
+  // primary registers none of them, so the parameter server hands the
+  // messages to this listener instead of relaying them to every renderer.
+  struct RendererStatsListener : osc::PacketHandler {
+    RendererBoard* board;
+    explicit RendererStatsListener(RendererBoard* board) : board(board) {}
+    void onMessage(osc::Message& message) override {
+      static const std::string suffix = "/rendererStats";
+      const std::string& address = message.addressPattern();
+      if (address.size() <= suffix.size() || message.typeTags() != "s" ||
+          address.compare(address.size() - suffix.size(), suffix.size(), suffix)) {
+        return;
+      }
+      ThreadTuning::get().adopt(ThreadTuning::NETWORK);
+      std::string text;
+      message >> text;
+      board->receive(text);
     }
-    this->registerParameters(width, gain, light, mode);
-  }
+  } rendererStatsListener{&renderers};
+
+  // renderers: a node is in sync once anything from the primary reaches its
+  // parameter server, whether or not a voice is playing
+  struct PrimaryListener : osc::PacketHandler {
+    StartupTimeline* timeline;
+    explicit PrimaryListener(StartupTimeline* timeline) : timeline(timeline) {}
+    void onMessage(osc::Message&) override { timeline->mark("synced with primary"); }
+  } primaryListener{&timeline};
+  ParameterString slowestRenderer{"renderers"};  // GUI line on the primary
+
+#ifndef RENDERER_ONLY
+  std::unique_ptr<PresetStore> presets;  // primary only, loads presets/
+  ParameterInt presetSlot{"preset", "", 7, 0, 99};  // recalled when set
+  Trigger storePreset{"storePreset", ""};  // saves into presetSlot
+  AudioReactor audio{SAMPLE_RATE};
+  std::unique_ptr<OfflineAudio> offlineAudio;  // --audio=null|file:...
+  ShowPlayer showPlayer;
+  ShowRecorder showRecorder;
+  std::unique_ptr<Exporter> exporter;  // started by the first export
+  std::atomic<bool> exportPending{false};  // set from preset callbacks too
+  bool exportArmed = false;  // render thread: pending before this update
+  std::atomic<int> exportPreset{-1};  // preset that asked for it, -1: a key
+  int exportCount = 0;
+#endif
 
-  void setMode(int desiredMode) {
-    this->mode = desiredMode;
-  }
+  void onInit() override {
+    timeline.node((isPrimary() ? "primary@" : "renderer@") + Socket::hostName());
+    timeline.mark("init");
+    std::cout << "Using " << kernels().isa << " kernels" << std::endl;
+    if (!options.metrics.empty()) {
+      metricsSink = std::make_unique<MetricsSink>(
+          options.metrics, options.metricsJson, options.metricsInterval,
+          (isPrimary() ? "primary@" : "renderer@") + Socket::hostName());
+    }
 
-  void toggleLight() {
-    this->light = !this->light;
-  }
+#ifdef RENDERER_ONLY
+    if (isPrimary()) {
+      std::cerr << "The renderer-only build can't run as primary" << std::endl;
+      quit();
+    }
+#else
+    // renderers never recall presets, so only the primary loads them
+    if (isPrimary()) {
+      presets = std::make_unique<PresetStore>("presets");
+    }
+#endif
 
-  void update(double dt) override {
-    system.reset();
-    system.primitive(Mesh::LINE_STRIP);  // defines the nature of the drawn
-    system.vertex(p[2], p[3], p[4]);
-
-    for (int i = 0; i < (int)p[0]; i++) {  // draw a point for each iteration
-      Vec3f _(system.vertices().back());
-
-      if (mode == 0) {
-        // Allotsucs, based on the Den Tsucs Attractor by Paul Bourke
-        float a(p[8]), c(p[10]), e(p[12]), o(p[14]);
-        float h(p[1]);
-        Vec3f f((a * (_.y - _.x)) + (_.x * _.z),  //
-                (o * _.y) - (_.x * _.z),          //
-                (c * _.z) + (_.x * _.y) - (e * pow(_.x, 2)));
-        system.vertex(_ + h * f);
-        // the line above is Euler's method! */
-      }
+    parameterServer() << showStamp;
+    if (isPrimary()) {
+      parameterServer().registerOSCListener(&rendererStatsListener);
+    } else {
+      rendererStats = std::make_unique<ParameterString>("rendererStats", options.name);
+      parameterServer() << *rendererStats;
+      parameterServer().registerOSCListener(&primaryListener);
+    }
+    if (!isPrimary()) {
+      showStamp.registerChangeCallback([this](std::string stamp) {
+        ThreadTuning::get().adopt(ThreadTuning::NETWORK);
+        timeline.mark("synced with primary");  // the first heartbeat at the latest
+        uint64_t sent = std::strtoull(stamp.c_str(), nullptr, 10);
+        double ms = (NodeReport::nowNs() - sent) / 1e6;
+        Metrics::local().record(Metrics::SYNC_LAG_MS, ms);
+        std::lock_guard<std::mutex> lock(stampLock);
+        report.syncLatency().add(ms);
+        auto apply = stamp.find(" apply ");
+        if (apply == std::string::npos) return;
+        int seq = std::atoi(stamp.c_str() + apply + 7);
+        if (seq > rebuiltSeq) {
+          pendingApplies[seq] = sent;
+        } else if (seq == rebuiltSeq) {
+          // the parameters overtook the stamp
+          report.applyLag().add((rebuiltNs - sent) / 1e6);
+        }
+      });
+    }
 
-      if (mode == 1) {
-        // Lorenz
-        float rho(p[5]), sigma(p[6]), beta(p[7]), h(p[1]);
-        Vec3f f(sigma * (_.y - _.x),      //
-                _.x * (rho - _.z) - _.y,  //
-                _.x * _.y - beta * _.z);
-        system.vertex(_ + h * f);
-        // the line above is Euler's method!
-      }
+    scene.registerSynthClass<Attractor>();
+    scene.allocatePolyphony<Attractor>(VOICE_POOL_SIZE);
+    scene.verbose(true);
+    this->registerDynamicScene(scene);
+  }
 
-      if (mode == 2) {
-        // Allorenz
-        float rho(p[5]), sigma(p[6]), beta(p[7]), h(p[1]);  // a, b, c
-        Vec3f f(_.y * _.z,          // main equation
-                rho * (_.x - _.y),  // main equation
-                sigma - beta * _.x * _.y - (1 - beta) * pow(_.x, 2));  // main
-        system.vertex(_ + h * f);
-        // the line above is Euler's method!
+  void onCreate() override {
+    timeline.mark("window");
+
+    // every pooled voice may rebuild in the same frame, so the render
+    // thread's arena holds all of their scratch
+    size_t scratch = 0;
+    for (auto* voice = scene.getFreeVoices(); voice; voice = voice->next) {
+      if (auto* attractor = dynamic_cast<Attractor*>(voice)) {
+        attractor->warm();
+        scratch += attractor->scratchBytes();
       }
+    }
+    FrameArena::local().reserve(scratch);
 
-      if (mode == 3) {
-        // Allorenz. Based on the Chen - Lee Attractor
-        float a(p[8]), b(p[9]), d(p[11]), h(p[1]);  // a, c, d, e, f
-        Vec3f f((a * _.x) - (_.y * _.z), (_.y * b) + (_.x * _.z),
-                (d * _.z) + (_.x * _.y / 3));
-
-        system.vertex(_ + h * f);
-        // the line above is Euler's method!
-      }
+    if (isPrimary()) {
+      nav().pos(0, 0, 10);
+#ifndef RENDERER_ONLY
+      prepareAttractor();
+      startOfflineAudio();
+      if (!options.show.empty()) showPlayer.load(options.show);
+      if (!options.recordShow.empty()) showRecorder.open(options.recordShow);
+#endif
+    } else {
+      nav().pos(0.101748, 0, 1.15022);
+      // nav().pos(-0.0081142, -0.0123074, 0.973139); // alt
     }
 
-    system.ribbonize(width, true);
-    system.primitive(Mesh::TRIANGLE_STRIP);
-    system.generateNormals();
+    // the audio thread tags itself on its first callback and allolib's
+    // network threads on their first parameter message
+    auto& tuning = ThreadTuning::get();
+    tuning.apply(ThreadTuning::RENDER);
+    if (options.lockMemory) {
+      tuning.lockMemory();
+    }
   }
 
-  void onProcess(Graphics& g) override {
-    g.depthTesting(light);
-    g.lighting(light);
-    g.blendTrans();
-    g.color(1);
-    g.scale(0.1);
-    g.draw(system);
+#ifndef RENDERER_ONLY
+  // Builds the voice, GUI and initial preset up front so the first spacebar
+  // press only has to trigger the voice
+  void prepareAttractor() {
+    mAttractor = scene.getVoice<Attractor>();
+    auto GUIdomain = GUIDomain::enableGUI(defaultWindowDomain());
+    ImGui::GetIO().IniFilename = "gui_layout.ini";  // persist window layout
+    auto& gui = GUIdomain->newGUI();
+    gui.add(slowestRenderer);
+    gui.add(presetSlot);
+    gui.add(storePreset);
+
+    auto params = mAttractor->parameters();
+    for (auto& param : params) {
+      if (mAttractor->bookkeeping(param)) continue;
+      gui.add(*param);
+      *presets << *param;
+    }
+    presets->start();
+
+    presets->recall(presetSlot);  // initial condition on startup, how to make autocue?
+    mAttractor->warm();  // size the mesh for the modes the preset enabled
+    mAttractor->update(0);
+
+    // recalls come from the GUI or a show; the export itself waits for the
+    // next scene update so it sees the recalled geometry
+    presetSlot.registerChangeCallback([this](int32_t index) {
+      if (!presets->recall(index)) {
+        std::cerr << "No preset " << index << std::endl;
+      } else if (options.exportOnPreset) {
+        exportPreset = index;
+        exportPending = true;
+      }
+    });
+    storePreset.registerChangeCallback([this](bool) { presets->store(presetSlot); });
   }
-};
 
-struct MyApp : public DistributedApp {  // use simple app if not distributed
-  PresetHandler presetHandler{"presets"};
-  DistributedScene scene;
-  Attractor* mAttractor = nullptr;
-
-  giml::Vactrol<float> mVactrol{SAMPLE_RATE};
+  // hands a snapshot of the attractor to the I/O thread
+  void exportGeometry() {
+    if (!mAttractorTriggered) return;
+    if (!exporter) exporter = std::make_unique<Exporter>(options.exportFormat);
+    auto snapshot = exporter->acquire();
+    mAttractor->snapshot(*snapshot, options.exportPoints);
+    int preset = exportPreset.exchange(-1);
+    snapshot->path = options.exportDir + "/attractor-" + std::to_string(++exportCount);
+    if (preset >= 0) snapshot->path += "-preset" + std::to_string(preset);
+    exporter->submit(std::move(snapshot));
+  }
 
-  void onInit() override {
-    scene.registerSynthClass<Attractor>();
-    scene.verbose(true);
-    this->registerDynamicScene(scene);
+  void startOfflineAudio() {
+    if (options.audio == "device") return;
+    offlineAudio = std::make_unique<OfflineAudio>();
+    offlineAudio->configure(AUDIO_CONFIG);
+    if (!offlineAudio->input(options.audioIn) ||
+        !offlineAudio->output(options.audioOut)) {
+      offlineAudio.reset();
+      return;
+    }
+    offlineAudio->start([this](AudioIOData& io) { onSound(io); },
+                        options.audioRealtime);
   }
 
-  void onCreate() override {
-    if (isPrimary()) {
-      nav().pos(0, 0, 10);
+  // primary commands, from the keyboard or a --show script
+  void perform(const std::string& command, const std::string& argument) {
+    if (command == "trigger" && !mAttractorTriggered) {
+      std::cout << "Making an attractor!" << std::endl;
+      scene.triggerOn(mAttractor);
+      mAttractorTriggered = true;
+
+      // renderers only receive parameter changes made after the trigger,
+      // so re-send the values recalled in onCreate
+      for (auto& param : mAttractor->parameters()) {
+        param->fromFloat(param->toFloat());
+      }
+      std::cout << "Finished making attractor!" << std::endl;
+    } else if (command == "light") {
+      mAttractor->toggleLight();
+    } else if (command == "mode") {
+      mAttractor->setMode(std::atoi(argument.c_str()));
+    } else if (command == "capture") {
+      mAttractor->capture(argument == "b" ? Morph::B : Morph::A);
+    } else if (command == "export") {
+      exportPending = true;
+      return;  // local to the primary, nothing for renderers to apply
+    } else if (command == "preset") {
+      presetSlot = std::atoi(argument.c_str());
+    } else if (command == "store") {
+      presets->store(presetSlot);
+      return;  // only writes files on the primary
+    } else if (command == "set") {
+      // "set <parameter> <value>"
+      auto split = argument.find(' ');
+      auto* param = mAttractor->parameter(argument.substr(0, split));
+      if (param && split != std::string::npos) {
+        param->fromFloat(std::atof(argument.c_str() + split + 1));
+      }
+    } else if (command == "quit") {
+      quit();
+      return;
     } else {
-      nav().pos(0.101748, 0, 1.15022);
-      // nav().pos(-0.0081142, -0.0123074, 0.973139); // alt
+      std::cerr << "Unknown command " << command << std::endl;
+      return;
     }
+    // numbered after the command's own changes, see Attractor::compute()
+    mAttractor->markApplied(++applySeq);
+    showStamp = std::to_string(NodeReport::nowNs()) + " apply " + std::to_string(applySeq);
   }
 
   void onSound(AudioIOData& io) override {
+    audio.prepareThread(io);  // first callback only
+    if (isPrimary()) audio.callback(io);
+  }
+#endif
+
+  void onAnimate(double dt) override { 
+#ifndef RENDERER_ONLY
+    if (presets) presets->applyReloaded();  // edited by hand while running
+    // an export asked for before this update sees what it rebuilt; one
+    // asked for during it (a preset callback on another thread, or the
+    // show below) waits for the next
+    exportArmed = exportPending.exchange(false);
+#endif
+    scene.update(dt); 
+    FrameArena::local().reset();  // voice scratch ends with the frame
+
+    elapsed += dt;
+    report.frame(dt);
+    auto& metrics = Metrics::local();
+    metrics.add(Metrics::FRAMES);
+    metrics.record(Metrics::FRAME_MS, dt * 1000);
+    if (options.duration > 0 && elapsed >= options.duration) {
+      quit();
+    }
+
     if (isPrimary()) {
-      for (auto sample = 0; sample < io.framesPerBuffer(); sample++) {
-        float in = io.in(0, sample);
-        float rectfied = abs(in);
-        float filtered = mVactrol(rectfied);
-
-        // "double warp"
-        filtered = std::log10((filtered * 9.0f) + 1.0f); // basic curve 
-        filtered = std::sqrt(filtered);  // ^0.5, general form is ^(1 / sensitivity)
-
-
-        // float scaled = giml::scale(filtered, 0, 1, 0.0, 0.007); // map to frequency range
-        if (mAttractor) {
-          auto params = mAttractor->parameters();
-          for (auto param : params) {
-            if (param->getName() == std::string("h")) {
-              auto param_cast = dynamic_cast<Parameter*>(param);
-              float scaledFor_h = giml::scale(filtered, 0, 1, 0.0, 0.007); // map to frequency range
-              *param_cast = scaledFor_h;
-            }
-          }
-        }
+#ifndef RENDERER_ONLY
+      if (exportArmed) exportGeometry();
+      showPlayer.poll(elapsed, [this](const ShowEvent& event) {
+        perform(event.command, event.argument);
+      });
+#endif
+      if (elapsed >= nextHeartbeat) {
+        showStamp = std::to_string(NodeReport::nowNs()) + " sync";
+        slowestRenderer = renderers.summary();
+        nextHeartbeat = elapsed + 0.5;
+      }
+    } else {
+      auto* attractor = dynamic_cast<Attractor*>(scene.getActiveVoices());
+      bool cacheHit = attractor && attractor->rebuilds() == lastRebuilds;
+      frameStats.frame(dt, attractor ? attractor->vertexCount() : 0, cacheHit);
+      if (elapsed >= nextHeartbeat) {
+        rendererStats->set(frameStats.take(options.name));
+        nextHeartbeat = elapsed + 0.5;
+      }
 
-        // "multi-stereo" output
-        for (auto channel = 0; channel < io.channelsOut(); channel++) {
-          if (channel % 2 == 0) {
-            io.out(channel, sample) = io.in(0, sample);
-          } else {
-            io.out(channel, sample) = io.in(1, sample);
-          }
-          
+      // apply lag ends with the rebuild that used the command's changes,
+      // not the next one audio input causes anyway
+      if (attractor && !cacheHit) {
+        lastRebuilds = attractor->rebuilds();
+        uint64_t now = NodeReport::nowNs();
+        std::lock_guard<std::mutex> lock(stampLock);
+        if (attractor->appliedSeq() > rebuiltSeq) {
+          rebuiltSeq = attractor->appliedSeq();
+          rebuiltNs = now;
+        }
+        auto applied = pendingApplies.upper_bound(rebuiltSeq);
+        for (auto i = pendingApplies.begin(); i != applied; ++i) {
+          report.applyLag().add((now - i->second) / 1e6);
         }
+        pendingApplies.erase(pendingApplies.begin(), applied);
       }
     }
-  }
 
-  void onAnimate(double dt) override { 
-    scene.update(dt); 
+#ifndef RENDERER_ONLY
+    // h is only read once per frame, and setting it from the audio thread
+    // would run the scene's network callbacks there
+    if (isPrimary() && mAttractor) {
+      mAttractor->audioInput(audio.level());
+    }
+#endif
+
+    // only once someone triggers a voice, unlike "synced with primary"
+    if (!isPrimary() && scene.getActiveVoices()) {
+      timeline.mark("first voice from primary");
+    }
 
     if (!isPrimary()) {
       // Rotate camera around Y axis for non-primary nodes
@@ -216,51 +423,66 @@ struct MyApp : public DistributedApp {  // use simple app if not distributed
     }
   }
 
+  void onExit() override {
+#ifndef RENDERER_ONLY
+    if (offlineAudio) offlineAudio->stop();
+    exporter.reset();  // finishes the queued exports
+#endif
+    if (!options.report.empty()) {
+      std::lock_guard<std::mutex> lock(stampLock);
+      report.write(options.report, (isPrimary() ? "primary@" : "renderer@") +
+                                       Socket::hostName());
+    }
+    if (options.threadReport) {
+      ThreadTuning::get().report(std::cout);
+    }
+    metricsSink.reset();  // final dump
+    if (isPrimary()) {
+      renderers.print(std::cout);
+    }
+  }
+
   void onDraw(Graphics& g) override {
     g.clear(0);
 
     // draw system if it exists
     scene.render(g);
+    timeline.mark("first frame");
   }
 
   bool onKeyDown(const Keyboard& k) override {
+#ifndef RENDERER_ONLY
     if (isPrimary()) {
-      if (!mAttractor) {
+      std::string command, argument;
+      if (!mAttractorTriggered) {
         if (k.key() == ' ') {
-          std::cout << "Making an attractor!" << std::endl;
-          mAttractor = scene.getVoice<Attractor>();
-          scene.triggerOn(mAttractor);
-          auto GUIdomain = GUIDomain::enableGUI(defaultWindowDomain());
-          auto& gui = GUIdomain->newGUI();
-          gui.add(presetHandler);
-
-          auto params = mAttractor->parameters();
-          for (auto& param : params) {
-            gui.add(*param);
-            presetHandler << *param;
-          }
-
-          presetHandler.recallPresetSynchronous(7);  // initial condition on startup, how to make autocue?
-          std::cout << "Finished making attractor!" << std::endl;
+          command = "trigger";
         }
       } else {
         if (k.key() == 'l') {
-          mAttractor->toggleLight();
+          command = "light";
         }
-        else if (isPrimary() && k.key() == '0') {
-          mAttractor->setMode(0);
+        else if (k.key() >= '0' && k.key() <= '3') {
+          command = "mode";
+          argument = std::string(1, (char)k.key());
         }
-        else if (isPrimary() && k.key() == '1') {
-          mAttractor->setMode(1);
+        else if (k.key() == 'a' || k.key() == 'b') {
+          command = "capture";
+          argument = std::string(1, (char)k.key());
         }
-        else if (isPrimary() && k.key() == '2') {
-          mAttractor->setMode(2);
+        else if (k.key() == 'e') {
+          command = "export";
         }
-        else if (isPrimary() && k.key() == '3') {
-          mAttractor->setMode(3);
+        else if (k.key() == 's') {
+          command = "store";
         }
       }
+      if (!command.empty()) {
+        showRecorder.record(elapsed, command, argument);
+        perform(command, argument);
+      }
     }
+#endif
     if (k.key() == 'p') {
       std::cout << "Position: " << this->nav().pos() << std::endl;
     }
@@ -269,8 +491,16 @@ struct MyApp : public DistributedApp {  // use simple app if not distributed
 
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+  StartupTimeline::processStart();
   MyApp app;
-  app.configureAudio(AUDIO_CONFIG);
+  app.options = Options::parse(argc, argv);
+  if (app.options.name.empty()) app.options.name = Socket::hostName();
+  ThreadTuning::get().configure(app.options.pin, app.options.priority);
+#ifndef RENDERER_ONLY
+  if (app.options.audio == "device") {
+    app.configureAudio(AUDIO_CONFIG);
+  }
+#endif
   app.start();
 }
\ No newline at end of file